@@ -0,0 +1,250 @@
+/***************************************************
+ * QrCache.h - Recently shown QR codes, kept by hash
+ * A counter shows the same few codes over and over.
+ * Each message is keyed by the FNV-1a hash of its bytes;
+ * the matrices of the last few sit packed in RAM, and
+ * the last QR_CACHE_FLASH in files on a flash file
+ * system (LittleFS) so they survive a reboot. A
+ * repeated message, or one that only names the hash
+ * ('H' and 8 hex digits), is shown from the cache
+ * without decoding or encoding anything.
+ ***************************************************/
+
+#ifndef QR_CACHE_H
+#define QR_CACHE_H
+
+#include <Arduino.h>
+#include "QrMatrix.h"
+
+// Matrices kept packed in RAM (41x41 takes 246 bytes)
+#ifndef QR_CACHE_RAM
+#define QR_CACHE_RAM 4
+#endif
+
+// Matrices kept in flash, one file each
+#ifndef QR_CACHE_FLASH
+#define QR_CACHE_FLASH 16
+#endif
+
+// File names: prefix + 8 hex digits, and prefix + "index" (the hashes in
+// flash, most recently shown first)
+#ifndef QR_CACHE_PREFIX
+#define QR_CACHE_PREFIX "/qr-"
+#endif
+
+#define QR_HASH_MAGIC 'H'
+
+// FS: fs::FS on the device (LittleFS), or anything with the same open(),
+// exists() and remove(); NULL keeps the cache in RAM only
+template<typename FS>
+class QrCache {
+public:
+  QrCache() : _fs(NULL), _clock(0), _flashCount(0) {
+    memset(_ram, 0, sizeof(_ram));
+  }
+  ~QrCache() {
+    for (uint8_t i = 0; i < QR_CACHE_RAM; i++) free(_ram[i].bits);
+  }
+
+  // Picks up the codes kept in flash by an earlier boot
+  void begin(FS *fs) {
+    _fs = fs;
+    _flashCount = 0;
+    if (!_fs) return;
+    char path[24];
+    indexPath(path);
+    if (!_fs->exists(path)) return;
+    auto f = _fs->open(path, "r");
+    if (!f) return;
+    uint8_t raw[4];
+    while (_flashCount < QR_CACHE_FLASH && f.read(raw, 4) == 4) {
+      _flash[_flashCount++] = (uint32_t)raw[0] | (uint32_t)raw[1] << 8 |
+                              (uint32_t)raw[2] << 16 | (uint32_t)raw[3] << 24;
+    }
+    f.close();
+  }
+
+  static uint32_t hash(const uint8_t *data, unsigned int len) {
+    uint32_t h = 2166136261UL;
+    for (unsigned int i = 0; i < len; i++) h = (h ^ data[i]) * 16777619UL;
+    return h;
+  }
+
+  // True if the message is 'H' and the hash of one sent before, as 8 hex digits
+  static bool hashMessage(const uint8_t *data, unsigned int len, uint32_t &key) {
+    if (len != 9 || data[0] != QR_HASH_MAGIC) return false;
+    key = 0;
+    for (uint8_t i = 1; i < 9; i++) {
+      uint8_t c = data[i] | 0x20, digit;
+      if (c >= '0' && c <= '9') digit = c - '0';
+      else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+      else return false;
+      key = key << 4 | digit;
+    }
+    return true;
+  }
+
+  // The matrix kept under key into out, from RAM or else from flash
+  bool find(uint32_t key, QrMatrix &out) {
+    int8_t i = ramSlot(key);
+    if (i >= 0) {
+      _ram[i].stamp = ++_clock;
+      unpack(_ram[i], out);
+      touchFlash(key);
+      return true;
+    }
+    if (!load(key, out)) return false;
+    keepInRam(key, out);
+    touchFlash(key);
+    return true;
+  }
+
+  // Keep a matrix just decoded under the hash of its message
+  void put(uint32_t key, const QrMatrix &m) {
+    if (!m.size()) return;
+    keepInRam(key, m);
+    if (!_fs) return;
+    int8_t at = flashSlot(key);
+    if (at < 0) {
+      if (_flashCount == QR_CACHE_FLASH) {
+        char path[24];
+        entryPath(path, _flash[--_flashCount]);
+        _fs->remove(path);
+      }
+      if (!store(key, m)) return;
+      at = _flashCount++;
+      _flash[at] = key;
+    }
+    moveToFront(at);
+    saveIndex();
+  }
+
+  uint8_t inFlash() const { return _flashCount; }
+
+private:
+  struct Entry {
+    uint32_t key;
+    uint32_t stamp;  // last use, for LRU
+    uint8_t size;
+    uint8_t *bits;   // size rows of (size + 7) / 8 bytes
+  };
+
+  static uint16_t packedBytes(uint8_t size) { return (uint16_t)size * ((size + 7) / 8); }
+
+  int8_t ramSlot(uint32_t key) const {
+    for (uint8_t i = 0; i < QR_CACHE_RAM; i++) {
+      if (_ram[i].bits && _ram[i].key == key) return i;
+    }
+    return -1;
+  }
+
+  void keepInRam(uint32_t key, const QrMatrix &m) {
+    int8_t slot = ramSlot(key);
+    if (slot < 0) {
+      slot = 0;
+      for (uint8_t i = 0; i < QR_CACHE_RAM; i++) {
+        if (!_ram[i].bits) { slot = i; break; }
+        if ((int32_t)(_ram[i].stamp - _ram[slot].stamp) < 0) slot = i;
+      }
+    }
+    Entry &e = _ram[slot];
+    if (!e.bits || e.size != m.size()) {
+      free(e.bits);
+      e.bits = (uint8_t *)malloc(packedBytes(m.size()));
+      if (!e.bits) return;
+    }
+    e.key = key;
+    e.stamp = ++_clock;
+    e.size = m.size();
+    uint8_t rowBytes = (e.size + 7) / 8;
+    for (uint8_t y = 0; y < e.size; y++) memcpy(e.bits + y * rowBytes, m.row(y), rowBytes);
+  }
+
+  static void unpack(const Entry &e, QrMatrix &out) {
+    uint8_t rowBytes = (e.size + 7) / 8;
+    out.setSize(e.size);
+    for (uint8_t y = 0; y < e.size; y++) memcpy(out.row(y), e.bits + y * rowBytes, rowBytes);
+  }
+
+  int8_t flashSlot(uint32_t key) const {
+    for (uint8_t i = 0; i < _flashCount; i++) {
+      if (_flash[i] == key) return i;
+    }
+    return -1;
+  }
+
+  void moveToFront(uint8_t at) {
+    uint32_t key = _flash[at];
+    memmove(_flash + 1, _flash, at * sizeof(_flash[0]));
+    _flash[0] = key;
+  }
+
+  // Hits only reorder the index in RAM, so showing a code never writes
+  // flash; the next put() saves the order
+  void touchFlash(uint32_t key) {
+    int8_t at = flashSlot(key);
+    if (at > 0) moveToFront(at);
+  }
+
+  // A file holds the size byte and the packed rows
+  bool store(uint32_t key, const QrMatrix &m) {
+    char path[24];
+    entryPath(path, key);
+    auto f = _fs->open(path, "w");
+    if (!f) return false;
+    uint8_t size = m.size(), rowBytes = (size + 7) / 8;
+    bool ok = f.write(&size, 1) == 1;
+    for (uint8_t y = 0; ok && y < size; y++) ok = f.write(m.row(y), rowBytes) == rowBytes;
+    f.close();
+    if (!ok) _fs->remove(path);
+    return ok;
+  }
+
+  bool load(uint32_t key, QrMatrix &out) {
+    int8_t at = flashSlot(key);
+    if (!_fs || at < 0) return false;
+    char path[24];
+    entryPath(path, key);
+    auto f = _fs->open(path, "r");
+    uint8_t size = 0;
+    bool ok = f && f.read(&size, 1) == 1 && size >= 1 && size <= QR_MATRIX_MAX;
+    uint8_t rowBytes = (size + 7) / 8;
+    if (ok) out.reset(size);
+    for (uint8_t y = 0; ok && y < size; y++) ok = f.read(out.row(y), rowBytes) == rowBytes;
+    if (f) f.close();
+    if (!ok) {
+      // Gone or cut short: forget it
+      out.reset(0);
+      memmove(_flash + at, _flash + at + 1, (_flashCount - at - 1) * sizeof(_flash[0]));
+      _flashCount--;
+      saveIndex();
+    }
+    return ok;
+  }
+
+  void saveIndex() {
+    char path[24];
+    indexPath(path);
+    auto f = _fs->open(path, "w");
+    if (!f) return;
+    for (uint8_t i = 0; i < _flashCount; i++) {
+      uint8_t raw[4] = { (uint8_t)_flash[i], (uint8_t)(_flash[i] >> 8),
+                         (uint8_t)(_flash[i] >> 16), (uint8_t)(_flash[i] >> 24) };
+      f.write(raw, 4);
+    }
+    f.close();
+  }
+
+  static void entryPath(char *path, uint32_t key) {
+    snprintf(path, 24, QR_CACHE_PREFIX "%08lx", (unsigned long)key);
+  }
+  static void indexPath(char *path) { snprintf(path, 24, QR_CACHE_PREFIX "index"); }
+
+  FS *_fs;
+  Entry _ram[QR_CACHE_RAM];
+  uint32_t _clock;
+  uint32_t _flash[QR_CACHE_FLASH];  // hashes in flash, most recent first
+  uint8_t _flashCount;
+};
+
+#endif // QR_CACHE_H
@@ -0,0 +1,418 @@
+/***************************************************
+ * QrEncode.h - QR encoder for short text payloads
+ * Builds the module matrix on the device from the text
+ * itself (byte mode, ECC level L/M/Q/H, versions 1-20,
+ * smallest version that fits, mask by the standard's
+ * penalty rules), so the message only has to carry the
+ * text. One 1085-byte codeword buffer: the text waits at
+ * its front while the bit stream overwrites it, the ECC
+ * goes behind the data, and interleaving happens while
+ * the modules are placed.
+ ***************************************************/
+
+#ifndef QR_ENCODE_H
+#define QR_ENCODE_H
+
+#include <Arduino.h>
+#include "QrMatrix.h"
+
+#define QR_ENCODE_MAX_VERSION   20
+#define QR_ENCODE_MAX_CODEWORDS 1085  // version 20
+#define QR_ENCODE_MAX_TEXT      858   // bytes version 20-L holds
+#define QR_ENCODE_MAX_ECC       30    // ECC codewords per block
+
+enum QrEcc { QR_ECC_L, QR_ECC_M, QR_ECC_Q, QR_ECC_H };
+
+// ISO/IEC 18004 table 9 for versions 1..20: ECC codewords per block, blocks
+static const uint8_t QR_ECC_PER_BLOCK[4][QR_ENCODE_MAX_VERSION + 1] PROGMEM = {
+  { 0,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28 },
+  { 0, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26 },
+  { 0, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30 },
+  { 0, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28 }
+};
+static const uint8_t QR_ECC_BLOCKS[4][QR_ENCODE_MAX_VERSION + 1] PROGMEM = {
+  { 0, 1, 1, 1, 1, 1, 2, 2, 2, 2,  4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8 },
+  { 0, 1, 1, 1, 2, 2, 4, 4, 4, 5,  5,  5,  8,  9,  9, 10, 10, 11, 13, 14, 16 },
+  { 0, 1, 1, 2, 2, 4, 4, 6, 6, 8,  8,  8, 10, 12, 16, 12, 17, 16, 18, 21, 20 },
+  { 0, 1, 1, 2, 4, 4, 4, 5, 6, 8,  8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25 }
+};
+
+class QrEncoder {
+public:
+  QrEncoder() : _len(0) {}
+
+  // Streaming text: begin(), append() every byte, then encode()
+  void begin() { _len = 0; }
+
+  // False once the text is longer than any version holds
+  bool append(uint8_t c) {
+    if (_len >= QR_ENCODE_MAX_TEXT) return false;
+    _buf[TEXT_AT + _len++] = c;
+    return true;
+  }
+
+  uint16_t length() const { return _len; }
+
+  // Encode the appended text into out; mask 0..7, or -1 for the one with the
+  // lowest penalty. False (out left empty) if it doesn't fit version 20.
+  bool encode(uint8_t ecc, QrMatrix &out, int8_t mask = -1) {
+    out.reset(0);
+    uint8_t version = versionFor(_len, ecc);
+    if (!version || ecc > QR_ECC_H || mask > 7) return false;
+    _version = version;
+    _size = 17 + 4 * version;
+    _ecc = ecc;
+    layout();
+    writeData();
+    writeEcc();
+
+    out.reset(_size);
+    drawFunctions(out);
+    placeCodewords(out);
+    if (mask < 0) {
+      long best = 0;
+      for (uint8_t m = 0; m < 8; m++) {
+        applyMask(out, m);
+        drawFormat(out, m);
+        long penalty = penaltyScore(out);
+        if (m == 0 || penalty < best) {
+          best = penalty;
+          mask = m;
+        }
+        applyMask(out, m);  // XOR: undone
+      }
+    }
+    applyMask(out, mask);
+    drawFormat(out, mask);
+    return true;
+  }
+
+  // Whole text at once
+  bool encode(const uint8_t *text, uint16_t len, uint8_t ecc, QrMatrix &out, int8_t mask = -1) {
+    begin();
+    for (uint16_t i = 0; i < len; i++) {
+      if (!append(text[i])) {
+        out.reset(0);
+        return false;
+      }
+    }
+    return encode(ecc, out, mask);
+  }
+
+  // Smallest version that holds len bytes at ecc, 0 if none up to 20
+  static uint8_t versionFor(uint16_t len, uint8_t ecc) {
+    if (ecc > QR_ECC_H) return 0;
+    for (uint8_t v = 1; v <= QR_ENCODE_MAX_VERSION; v++) {
+      uint32_t bits = 4 + countBits(v) + 8UL * len;
+      if (bits <= 8UL * dataCodewords(v, ecc)) return v;
+    }
+    return 0;
+  }
+
+  static uint16_t totalCodewords(uint8_t version) {
+    uint32_t modules = (16UL * version + 128) * version + 64;
+    if (version >= 2) {
+      uint8_t align = version / 7 + 2;
+      modules -= (25UL * align - 10) * align - 55;
+      if (version >= 7) modules -= 36;
+    }
+    return modules / 8;
+  }
+
+  static uint16_t dataCodewords(uint8_t version, uint8_t ecc) {
+    return totalCodewords(version) -
+           pgm_read_byte(&QR_ECC_PER_BLOCK[ecc][version]) * pgm_read_byte(&QR_ECC_BLOCKS[ecc][version]);
+  }
+
+private:
+  // The text sits this far in, so the mode and count bits (at most 20) fit
+  // in front of it and each byte is read before the bit stream reaches it
+  static const uint8_t TEXT_AT = 3;
+
+  static uint8_t countBits(uint8_t version) { return version < 10 ? 8 : 16; }
+
+  // Block structure: the short blocks come first, long ones carry one more
+  // data codeword
+  void layout() {
+    _blocks = pgm_read_byte(&QR_ECC_BLOCKS[_ecc][_version]);
+    _eccLen = pgm_read_byte(&QR_ECC_PER_BLOCK[_ecc][_version]);
+    _total = totalCodewords(_version);
+    _dataLen = _total - _blocks * _eccLen;
+    _shortBlocks = _blocks - _total % _blocks;
+    _shortData = _total / _blocks - _eccLen;
+  }
+
+  uint16_t blockStart(uint8_t b) const {
+    return b * _shortData + (b > _shortBlocks ? b - _shortBlocks : 0);
+  }
+  uint16_t blockData(uint8_t b) const { return _shortData + (b >= _shortBlocks ? 1 : 0); }
+
+  // Mode, count, text, terminator and pad bytes into the first _dataLen bytes
+  void writeData() {
+    _bit = 0;
+    put(0x4, 4);  // byte mode
+    put(_len, countBits(_version));
+    for (uint16_t i = 0; i < _len; i++) put(_buf[TEXT_AT + i], 8);
+    uint32_t capacity = 8UL * _dataLen;
+    put(0, min((uint32_t)4, capacity - _bit));
+    if (_bit % 8) put(0, 8 - _bit % 8);
+    for (uint8_t pad = 0xEC; _bit < capacity; pad ^= 0xEC ^ 0x11) put(pad, 8);
+  }
+
+  // A byte is cleared when the stream first reaches it: what it held (the
+  // text) has been read by then
+  void put(uint16_t value, uint8_t bits) {
+    while (bits--) {
+      if (_bit % 8 == 0) _buf[_bit / 8] = 0;
+      if ((value >> bits) & 1) _buf[_bit / 8] |= 0x80 >> (_bit % 8);
+      _bit++;
+    }
+  }
+
+  // Reed-Solomon remainder of every block, behind all the data
+  void writeEcc() {
+    uint8_t divisor[QR_ENCODE_MAX_ECC];
+    memset(divisor, 0, _eccLen);
+    divisor[_eccLen - 1] = 1;
+    uint8_t root = 1;
+    for (uint8_t i = 0; i < _eccLen; i++) {
+      for (uint8_t j = 0; j < _eccLen; j++) {
+        divisor[j] = gfMul(divisor[j], root);
+        if (j + 1 < _eccLen) divisor[j] ^= divisor[j + 1];
+      }
+      root = gfMul(root, 0x02);
+    }
+    for (uint8_t b = 0; b < _blocks; b++) {
+      const uint8_t *data = _buf + blockStart(b);
+      uint8_t *rem = _buf + _dataLen + b * _eccLen;
+      memset(rem, 0, _eccLen);
+      for (uint16_t i = 0; i < blockData(b); i++) {
+        uint8_t factor = data[i] ^ rem[0];
+        memmove(rem, rem + 1, _eccLen - 1);
+        rem[_eccLen - 1] = 0;
+        for (uint8_t j = 0; j < _eccLen; j++) rem[j] ^= gfMul(divisor[j], factor);
+      }
+    }
+  }
+
+  static uint8_t gfMul(uint8_t x, uint8_t y) {
+    uint16_t z = 0;
+    for (int8_t i = 7; i >= 0; i--) {
+      z = (z << 1) ^ ((z >> 7) * 0x11D);
+      z ^= ((y >> i) & 1) * x;
+    }
+    return z;
+  }
+
+  // Codeword i of the interleaved sequence: data codeword k of every block
+  // in turn (the long blocks' extra one last), then ECC codeword k likewise
+  uint8_t interleaved(uint16_t i) const {
+    uint16_t shortPart = (uint16_t)_blocks * _shortData;
+    if (i < shortPart) return _buf[blockStart(i % _blocks) + i / _blocks];
+    if (i < _dataLen) return _buf[blockStart(_shortBlocks + i - shortPart) + _shortData];
+    i -= _dataLen;
+    return _buf[_dataLen + (i % _blocks) * _eccLen + i / _blocks];
+  }
+
+  // Alignment pattern centres along one axis; returns how many
+  uint8_t alignment(uint8_t *pos) const {
+    if (_version == 1) return 0;
+    uint8_t count = _version / 7 + 2;
+    uint8_t step = (_version * 8 + count * 3 + 5) / (count * 4 - 4) * 2;
+    pos[0] = 6;
+    for (uint8_t i = count - 1, p = _size - 7; i >= 1; i--, p -= step) pos[i] = p;
+    return count;
+  }
+
+  // Finders with separators and format areas, timing, alignment, version
+  bool isFunction(uint8_t x, uint8_t y) const {
+    if (x == 6 || y == 6) return true;
+    if (y < 9 && (x < 9 || x >= _size - 8)) return true;
+    if (x < 9 && y >= _size - 8) return true;
+    if (_version >= 7 && ((x >= _size - 11 && x < _size - 8 && y < 6) ||
+                          (y >= _size - 11 && y < _size - 8 && x < 6))) return true;
+    uint8_t pos[7], count = alignment(pos);
+    for (uint8_t i = 0; i < count; i++) {
+      if (abs(x - pos[i]) > 2) continue;
+      for (uint8_t j = 0; j < count; j++) {
+        if (abs(y - pos[j]) > 2) continue;
+        return !isCorner(i, j, count);
+      }
+    }
+    return false;
+  }
+
+  // Alignment centres that would sit on a finder
+  static bool isCorner(uint8_t i, uint8_t j, uint8_t count) {
+    return (i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0);
+  }
+
+  void drawFunctions(QrMatrix &m) const {
+    for (uint8_t i = 0; i < _size; i++) {
+      m.set(6, i, i % 2 == 0);
+      m.set(i, 6, i % 2 == 0);
+    }
+    drawFinder(m, 3, 3);
+    drawFinder(m, _size - 4, 3);
+    drawFinder(m, 3, _size - 4);
+
+    uint8_t pos[7], count = alignment(pos);
+    for (uint8_t i = 0; i < count; i++) {
+      for (uint8_t j = 0; j < count; j++) {
+        if (isCorner(i, j, count)) continue;
+        for (int8_t dy = -2; dy <= 2; dy++) {
+          for (int8_t dx = -2; dx <= 2; dx++) {
+            m.set(pos[i] + dx, pos[j] + dy, max(abs(dx), abs(dy)) != 1);
+          }
+        }
+      }
+    }
+
+    if (_version >= 7) {
+      uint32_t rem = _version;
+      for (uint8_t i = 0; i < 12; i++) rem = (rem << 1) ^ ((rem >> 11) * 0x1F25);
+      uint32_t bits = (uint32_t)_version << 12 | rem;
+      for (uint8_t i = 0; i < 18; i++) {
+        bool dark = (bits >> i) & 1;
+        uint8_t a = _size - 11 + i % 3, b = i / 3;
+        m.set(a, b, dark);
+        m.set(b, a, dark);
+      }
+    }
+  }
+
+  void drawFinder(QrMatrix &m, uint8_t cx, uint8_t cy) const {
+    for (int8_t dy = -4; dy <= 4; dy++) {
+      for (int8_t dx = -4; dx <= 4; dx++) {
+        int16_t x = cx + dx, y = cy + dy;
+        if (x < 0 || y < 0 || x >= _size || y >= _size) continue;
+        uint8_t dist = max(abs(dx), abs(dy));
+        m.set(x, y, dist != 2 && dist != 4);
+      }
+    }
+  }
+
+  // Both copies of the format word (ECC level and mask), and the dark module
+  void drawFormat(QrMatrix &m, uint8_t mask) const {
+    static const uint8_t LEVEL[4] = { 1, 0, 3, 2 };  // L M Q H as encoded
+    uint16_t data = LEVEL[_ecc] << 3 | mask;
+    uint16_t rem = data;
+    for (uint8_t i = 0; i < 10; i++) rem = (rem << 1) ^ ((rem >> 9) * 0x537);
+    uint16_t bits = (data << 10 | rem) ^ 0x5412;
+
+    for (uint8_t i = 0; i <= 5; i++) m.set(8, i, (bits >> i) & 1);
+    m.set(8, 7, (bits >> 6) & 1);
+    m.set(8, 8, (bits >> 7) & 1);
+    m.set(7, 8, (bits >> 8) & 1);
+    for (uint8_t i = 9; i < 15; i++) m.set(14 - i, 8, (bits >> i) & 1);
+    for (uint8_t i = 0; i < 8; i++) m.set(_size - 1 - i, 8, (bits >> i) & 1);
+    for (uint8_t i = 8; i < 15; i++) m.set(8, _size - 15 + i, (bits >> i) & 1);
+    m.set(8, _size - 8, true);
+  }
+
+  // Two-module columns from the right, zig-zagging up and down, skipping the
+  // timing column; remainder bits stay light
+  void placeCodewords(QrMatrix &m) const {
+    uint32_t bit = 0, bits = 8UL * _total;
+    for (int16_t right = _size - 1; right >= 1; right -= 2) {
+      if (right == 6) right = 5;
+      bool upward = ((right + 1) & 2) == 0;
+      for (uint8_t vert = 0; vert < _size; vert++) {
+        uint8_t y = upward ? _size - 1 - vert : vert;
+        for (uint8_t j = 0; j < 2; j++) {
+          uint8_t x = right - j;
+          if (isFunction(x, y) || bit >= bits) continue;
+          m.set(x, y, (interleaved(bit / 8) >> (7 - bit % 8)) & 1);
+          bit++;
+        }
+      }
+    }
+  }
+
+  void applyMask(QrMatrix &m, uint8_t mask) const {
+    for (uint8_t y = 0; y < _size; y++) {
+      for (uint8_t x = 0; x < _size; x++) {
+        bool invert;
+        switch (mask) {
+          case 0:  invert = (x + y) % 2 == 0; break;
+          case 1:  invert = y % 2 == 0; break;
+          case 2:  invert = x % 3 == 0; break;
+          case 3:  invert = (x + y) % 3 == 0; break;
+          case 4:  invert = (x / 3 + y / 2) % 2 == 0; break;
+          case 5:  invert = x * y % 2 + x * y % 3 == 0; break;
+          case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0; break;
+          default: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+        }
+        if (invert && !isFunction(x, y)) m.set(x, y, !m.get(x, y));
+      }
+    }
+  }
+
+  // Penalty rules N1 (runs of five or more), N2 (2x2 blocks), N3 (finder-like
+  // 1:1:3:1:1 with four light modules on a side, the quiet zone counting as
+  // light) and N4 (dark/light balance)
+  long penaltyScore(const QrMatrix &m) const {
+    long score = 0;
+    for (uint8_t pass = 0; pass < 2; pass++) {
+      for (uint8_t a = 0; a < _size; a++) {
+        bool color = false;
+        uint16_t run = 0;
+        uint16_t history[7] = { 0 };
+        for (uint8_t b = 0; b < _size; b++) {
+          bool dark = pass ? m.get(a, b) : m.get(b, a);
+          if (dark == color) {
+            run++;
+            if (run == 5) score += 3;
+            else if (run > 5) score++;
+          } else {
+            addHistory(history, run);
+            if (!color) score += finderLike(history) * 40;
+            color = dark;
+            run = 1;
+          }
+        }
+        if (color) {
+          addHistory(history, run);
+          run = 0;
+        }
+        addHistory(history, run + _size);
+        score += finderLike(history) * 40;
+      }
+    }
+
+    uint32_t dark = 0;
+    for (uint8_t y = 0; y < _size; y++) {
+      for (uint8_t x = 0; x < _size; x++) {
+        bool c = m.get(x, y);
+        dark += c;
+        if (x + 1 < _size && y + 1 < _size && c == m.get(x + 1, y) &&
+            c == m.get(x, y + 1) && c == m.get(x + 1, y + 1)) score += 3;
+      }
+    }
+    long total = (long)_size * _size;
+    long k = (labs((long)dark * 20 - total * 10) + total - 1) / total - 1;
+    return score + k * 10;
+  }
+
+  // Run lengths, newest first; the first run of a line includes the quiet zone
+  void addHistory(uint16_t *history, uint16_t run) const {
+    if (history[0] == 0) run += _size;
+    memmove(history + 1, history, 6 * sizeof(history[0]));
+    history[0] = run;
+  }
+
+  static uint8_t finderLike(const uint16_t *h) {
+    uint16_t n = h[1];
+    bool core = n > 0 && h[2] == n && h[3] == n * 3 && h[4] == n && h[5] == n;
+    return (core && h[0] >= n * 4 && h[6] >= n) + (core && h[6] >= n * 4 && h[0] >= n);
+  }
+
+  uint8_t _buf[QR_ENCODE_MAX_CODEWORDS];
+  uint16_t _len;       // text bytes appended
+  uint32_t _bit;       // write position of the data bit stream
+  uint8_t _version, _size, _ecc;
+  uint8_t _blocks, _eccLen, _shortBlocks, _shortData;
+  uint16_t _total, _dataLen;
+};
+
+#endif // QR_ENCODE_H
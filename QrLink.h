@@ -0,0 +1,190 @@
+/***************************************************
+ * QrLink.h - WiFi and MQTT bring-up without blocking
+ * A state machine that loop() polls: join WiFi, connect
+ * and subscribe to the broker, stay online, and when
+ * either drops, retry with exponential backoff and
+ * jitter instead of delay(). The display keeps running
+ * meanwhile; state changes go to a listener, so status
+ * is drawn once per change rather than per retry.
+ * What still blocks: the broker's name is looked up
+ * once per WiFi join, as long as DNS takes; after that
+ * each try waits at most the WiFiClient's connect
+ * timeout for TCP, then PubSubClient's socket timeout
+ * for the broker's answer. The sketch sets both.
+ ***************************************************/
+
+#ifndef QR_LINK_H
+#define QR_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+
+// Retry delays double from MIN to MAX; each is jittered to 50-100 %
+#ifndef QR_LINK_BACKOFF_MIN_MS
+#define QR_LINK_BACKOFF_MIN_MS 500UL
+#endif
+#ifndef QR_LINK_BACKOFF_MAX_MS
+#define QR_LINK_BACKOFF_MAX_MS 30000UL
+#endif
+
+// A WiFi join that takes longer starts over
+#ifndef QR_LINK_JOIN_TIMEOUT_MS
+#define QR_LINK_JOIN_TIMEOUT_MS 15000UL
+#endif
+
+enum QrLinkState {
+  QR_LINK_IDLE,          // before begin()
+  QR_LINK_WIFI_JOINING,  // WiFi.begin() sent, waiting for an IP
+  QR_LINK_WIFI_BACKOFF,  // join timed out, waiting to try again
+  QR_LINK_MQTT_BACKOFF,  // WiFi up, waiting to (re)connect to the broker
+  QR_LINK_ONLINE         // connected and subscribed
+};
+
+typedef void (*QrLinkListener)(uint8_t from, uint8_t to);
+
+class QrLink {
+public:
+  QrLink(WiFiClass &wifi, PubSubClient &mqtt)
+    : _wifi(wifi), _mqtt(mqtt), _state(QR_LINK_IDLE), _listener(NULL),
+      _attempts(0), _since(0), _retryAt(0), _ssid(NULL), _password(NULL),
+      _host(NULL), _port(0), _resolved(false),
+      _clientId(NULL), _user(NULL), _secret(NULL), _topic(NULL) {}
+
+  // The broker by name, handed to the client as an address once looked up.
+  // Without it the client's own setServer() stands (and a name set there is
+  // looked up on every try).
+  void setServer(const char *host, uint16_t port) {
+    _host = host;
+    _port = port;
+    _resolved = false;
+  }
+
+  // Strings are kept by pointer and must outlive the link
+  void setBroker(const char *clientId, const char *user, const char *password, const char *topic) {
+    _clientId = clientId;
+    _user = user;
+    _secret = password;
+    _topic = topic;
+  }
+
+  void onChange(QrLinkListener listener) { _listener = listener; }
+
+  void begin(const char *ssid, const char *password, unsigned long now) {
+    _ssid = ssid;
+    _password = password;
+    join(now);
+  }
+
+  // From loop(); returns at once whatever the network does
+  void poll(unsigned long now) {
+    bool wifiUp = _wifi.status() == WL_CONNECTED;
+    switch (_state) {
+      case QR_LINK_IDLE:
+        break;
+
+      case QR_LINK_WIFI_JOINING:
+        if (wifiUp) brokerSoon(now);
+        else if (now - _since >= QR_LINK_JOIN_TIMEOUT_MS) backoff(QR_LINK_WIFI_BACKOFF, now);
+        break;
+
+      case QR_LINK_WIFI_BACKOFF:
+        if (wifiUp) brokerSoon(now);
+        else if (due(now)) join(now);
+        break;
+
+      case QR_LINK_MQTT_BACKOFF:
+        if (!wifiUp) rejoin(now);
+        else if (due(now)) connect(now);
+        break;
+
+      case QR_LINK_ONLINE:
+        if (!wifiUp) rejoin(now);
+        else if (!_mqtt.loop()) backoff(QR_LINK_MQTT_BACKOFF, now);
+        break;
+    }
+  }
+
+  uint8_t state() const { return _state; }
+  bool online() const { return _state == QR_LINK_ONLINE; }
+  // Failed tries since the last success
+  uint16_t attempts() const { return _attempts; }
+  // When the next try is due, in the backoff states
+  unsigned long retryAt() const { return _retryAt; }
+
+private:
+  void enter(uint8_t state, unsigned long now) {
+    uint8_t from = _state;
+    _state = state;
+    _since = now;
+    if (from != state && _listener) _listener(from, state);
+  }
+
+  void join(unsigned long now) {
+    if (_state != QR_LINK_IDLE) _wifi.disconnect();
+    _resolved = false;
+    _wifi.begin(_ssid, _password);
+    enter(QR_LINK_WIFI_JOINING, now);
+  }
+
+  // WiFi lost: its own backoff starts from the bottom
+  void rejoin(unsigned long now) {
+    _attempts = 0;
+    join(now);
+  }
+
+  // WiFi just came up: the broker's turn, right away
+  void brokerSoon(unsigned long now) {
+    _attempts = 0;
+    _retryAt = now;
+    enter(QR_LINK_MQTT_BACKOFF, now);
+  }
+
+  void connect(unsigned long now) {
+    if (resolve() && _mqtt.connect(_clientId, _user, _secret) && _mqtt.subscribe(_topic)) {
+      _attempts = 0;
+      enter(QR_LINK_ONLINE, now);
+    } else {
+      backoff(QR_LINK_MQTT_BACKOFF, now);
+    }
+  }
+
+  // The broker's address, looked up once per WiFi join so that retries
+  // don't wait on DNS again
+  bool resolve() {
+    if (_resolved || !_host) return true;
+    IPAddress ip;
+    if (!_wifi.hostByName(_host, ip)) return false;
+    _mqtt.setServer(ip, _port);
+    _resolved = true;
+    return true;
+  }
+
+  // Next try after MIN * 2^attempts (at most MAX), a random 50-100 % of it
+  // so that devices that lost the same broker don't all come back at once
+  void backoff(uint8_t state, unsigned long now) {
+    unsigned long wait = QR_LINK_BACKOFF_MIN_MS;
+    for (uint16_t i = 0; i < _attempts && wait < QR_LINK_BACKOFF_MAX_MS; i++) wait *= 2;
+    wait = min(wait, QR_LINK_BACKOFF_MAX_MS);
+    _retryAt = now + wait / 2 + random(wait / 2 + 1);
+    if (_attempts < 0xFFFF) _attempts++;
+    enter(state, now);
+  }
+
+  bool due(unsigned long now) const { return (long)(now - _retryAt) >= 0; }
+
+  WiFiClass &_wifi;
+  PubSubClient &_mqtt;
+  uint8_t _state;
+  QrLinkListener _listener;
+  uint16_t _attempts;
+  unsigned long _since;    // entered the current state
+  unsigned long _retryAt;
+  const char *_ssid, *_password;
+  const char *_host;
+  uint16_t _port;
+  bool _resolved;          // _host looked up since the last join
+  const char *_clientId, *_user, *_secret, *_topic;
+};
+
+#endif // QR_LINK_H
@@ -0,0 +1,48 @@
+/***************************************************
+ * QrMatrix.h - Bit-packed QR module matrix
+ * One bit per module, rows padded to whole bytes,
+ * most significant bit first (the layout of the
+ * packed binary QR message). 200x200 takes 5 KB.
+ ***************************************************/
+
+#ifndef QR_MATRIX_H
+#define QR_MATRIX_H
+
+#include <Arduino.h>
+
+#define QR_MATRIX_MAX 200
+
+class QrMatrix {
+public:
+  static const uint8_t ROW_BYTES = (QR_MATRIX_MAX + 7) / 8;
+
+  QrMatrix() : _size(0) {}
+
+  // Empty (all light) matrix of size x size modules; 0 = no matrix
+  void reset(uint8_t size) {
+    _size = size;
+    memset(_bits, 0, sizeof(_bits));
+  }
+
+  uint8_t size() const { return _size; }
+  void setSize(uint8_t size) { _size = size; }
+
+  bool get(uint8_t x, uint8_t y) const {
+    return _bits[y][x >> 3] & (0x80 >> (x & 7));
+  }
+
+  void set(uint8_t x, uint8_t y, bool dark) {
+    if (dark) _bits[y][x >> 3] |= (0x80 >> (x & 7));
+    else _bits[y][x >> 3] &= ~(0x80 >> (x & 7));
+  }
+
+  // Packed bits of row y, (size + 7) / 8 bytes
+  uint8_t *row(uint8_t y) { return _bits[y]; }
+  const uint8_t *row(uint8_t y) const { return _bits[y]; }
+
+private:
+  uint8_t _size;
+  uint8_t _bits[QR_MATRIX_MAX][ROW_BYTES];
+};
+
+#endif // QR_MATRIX_H
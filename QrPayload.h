@@ -0,0 +1,179 @@
+/***************************************************
+ * QrPayload.h - Streaming QR message decoder
+ * Walks an MQTT payload byte by byte and writes the
+ * modules straight into a QrMatrix, without building
+ * a String or a JSON document first. Three formats:
+ *  - legacy JSON:  [[1,0,...],[0,1,...],...]
+ *  - packed:       'Q', size, then size rows of
+ *                  (size + 7) / 8 bytes, MSB first
+ *  - text:         'T', ECC level ('L', 'M', 'Q' or
+ *                  'H'), then the text the code holds,
+ *                  encoded here by QrEncode.h
+ ***************************************************/
+
+#ifndef QR_PAYLOAD_H
+#define QR_PAYLOAD_H
+
+#include <Arduino.h>
+#include "QrMatrix.h"
+#include "QrEncode.h"
+
+#define QR_MATRIX_MIN 10
+#define QR_PACKED_MAGIC 'Q'
+#define QR_TEXT_MAGIC 'T'
+
+class QrPayloadDecoder {
+public:
+  // Text messages need an encoder (1 KB); without one they fail
+  explicit QrPayloadDecoder(QrMatrix &matrix, QrEncoder *encoder = NULL)
+    : _m(matrix), _encoder(encoder), _state(FAILED) {}
+
+  // Whole payload at once; true if out now holds a valid matrix
+  static bool decode(const uint8_t *payload, unsigned int len, QrMatrix &out,
+                     QrEncoder *encoder = NULL) {
+    QrPayloadDecoder d(out, encoder);
+    d.begin();
+    d.feed(payload, len);
+    return d.end();
+  }
+
+  // Chunked use: begin(), feed() any number of times, end()
+  void begin() {
+    _m.reset(0);
+    _state = START;
+    _x = _y = 0;
+    _width = 0;
+    _inValue = false;
+  }
+
+  void feed(const uint8_t *data, unsigned int len) {
+    for (unsigned int i = 0; i < len && _state != FAILED; i++) step(data[i]);
+  }
+
+  // Checks the message is complete; on failure the matrix is left empty
+  bool end() {
+    bool ok = false;
+    if (_state == JSON_DONE) ok = _y == _width && _width >= QR_MATRIX_MIN;
+    else if (_state == PACKED_BITS) ok = _y == _width;
+    else if (_state == TEXT) ok = _encoder->length() && _encoder->encode(_ecc, _m);
+    if (_state != TEXT) _m.setSize(ok ? _width : 0);
+    _state = FAILED;
+    return ok;
+  }
+
+private:
+  enum {
+    START,
+    JSON_ROWS,       // inside the outer array, expecting a row
+    JSON_CELLS,      // inside a row
+    JSON_AFTER_ROW,  // expecting ',' or the final ']'
+    JSON_DONE,
+    PACKED_SIZE,
+    PACKED_BITS,
+    TEXT_ECC,
+    TEXT,
+    FAILED
+  };
+
+  static bool isSpace(uint8_t c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+  static bool isWordChar(uint8_t c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z'); }
+
+  void step(uint8_t c) {
+    switch (_state) {
+      case START:
+        if (c == '[') _state = JSON_ROWS;
+        else if (c == QR_PACKED_MAGIC) _state = PACKED_SIZE;
+        else if (c == QR_TEXT_MAGIC && _encoder) _state = TEXT_ECC;
+        else if (!isSpace(c)) _state = FAILED;
+        break;
+
+      case JSON_ROWS:
+        if (c == '[') {
+          if (_y >= QR_MATRIX_MAX) { _state = FAILED; break; }
+          _x = 0;
+          _state = JSON_CELLS;
+        } else if (c == ']' && _y == 0) {
+          _state = JSON_DONE;
+        } else if (!isSpace(c)) {
+          _state = FAILED;
+        }
+        break;
+
+      case JSON_CELLS:
+        // A value is a number (non-zero = dark) or true/false
+        if (isWordChar(c)) {
+          if (!_inValue) {
+            if (_x >= QR_MATRIX_MAX) { _state = FAILED; break; }
+            _inValue = true;
+            _dark = c == 't';
+          }
+          if (c >= '1' && c <= '9') _dark = true;
+          break;
+        }
+        if (_inValue) {
+          _m.set(_x++, _y, _dark);
+          _inValue = false;
+        }
+        if (c == ']') endRow();
+        else if (c != ',' && !isSpace(c)) _state = FAILED;
+        break;
+
+      case JSON_AFTER_ROW:
+        if (c == ',') _state = JSON_ROWS;
+        else if (c == ']') _state = JSON_DONE;
+        else if (!isSpace(c)) _state = FAILED;
+        break;
+
+      case JSON_DONE:
+        if (!isSpace(c)) _state = FAILED;
+        break;
+
+      case PACKED_SIZE:
+        if (c < QR_MATRIX_MIN || c > QR_MATRIX_MAX) { _state = FAILED; break; }
+        _width = c;
+        _state = PACKED_BITS;
+        break;
+
+      case PACKED_BITS:
+        // _x counts bytes within the row here
+        if (_y >= _width) { _state = FAILED; break; }
+        _m.row(_y)[_x++] = c;
+        if (_x == (_width + 7) / 8) {
+          _x = 0;
+          _y++;
+        }
+        break;
+
+      case TEXT_ECC: {
+        const char *levels = "LMQH";
+        const char *level = strchr(levels, c);
+        if (!c || !level) { _state = FAILED; break; }
+        _ecc = level - levels;
+        _encoder->begin();
+        _state = TEXT;
+        break;
+      }
+
+      case TEXT:
+        if (!_encoder->append(c)) _state = FAILED;
+        break;
+    }
+  }
+
+  // Every row must be as long as the first; the matrix is square
+  void endRow() {
+    if (_y == 0) _width = _x;
+    if (_x != _width || _width == 0) { _state = FAILED; return; }
+    _y++;
+    _state = JSON_AFTER_ROW;
+  }
+
+  QrMatrix &_m;
+  QrEncoder *_encoder;
+  uint8_t _state;
+  uint8_t _ecc;
+  uint8_t _x, _y, _width;
+  bool _inValue, _dark;
+};
+
+#endif // QR_PAYLOAD_H
@@ -0,0 +1,51 @@
+/***************************************************
+ * QrRender.h - Scaled QR output for SPI TFTs
+ * Each module row is expanded once into a line of
+ * pixels (same-colour modules as one run) and pushed
+ * moduleSize times into a single address window that
+ * covers the whole code. The screen around it is
+ * cleared with four rects, so no pixel is sent twice.
+ ***************************************************/
+
+#ifndef QR_RENDER_H
+#define QR_RENDER_H
+
+#include <Arduino.h>
+#include "QrMatrix.h"
+
+// line needs room for qr.size() * moduleSize pixels
+template<typename Display>
+void drawQrMatrix(Display &tft, const QrMatrix &qr, int16_t x, int16_t y, uint8_t moduleSize,
+                  uint16_t onColor, uint16_t offColor, uint16_t background, uint16_t *line) {
+  uint8_t size = qr.size();
+  int16_t side = (int16_t)size * moduleSize;
+
+  tft.startWrite();
+  // Everything outside the code: bands above and below, then left and right
+  int16_t below = y + side;
+  int16_t right = x + side;
+  if (y > 0) tft.writeFillRect(0, 0, tft.width(), y, background);
+  if (below < tft.height()) tft.writeFillRect(0, below, tft.width(), tft.height() - below, background);
+  if (x > 0) tft.writeFillRect(0, y, x, side, background);
+  if (right < tft.width()) tft.writeFillRect(right, y, tft.width() - right, side, background);
+
+  if (size) {
+    tft.setAddrWindow(x, y, side, side);
+    for (uint8_t my = 0; my < size; my++) {
+      uint16_t *p = line;
+      uint8_t mx = 0;
+      while (mx < size) {
+        bool on = qr.get(mx, my);
+        uint8_t run = 1;
+        while (mx + run < size && qr.get(mx + run, my) == on) run++;
+        uint16_t color = on ? onColor : offColor;
+        for (uint16_t n = (uint16_t)run * moduleSize; n > 0; n--) *p++ = color;
+        mx += run;
+      }
+      for (uint8_t r = 0; r < moduleSize; r++) tft.writePixels(line, side);
+    }
+  }
+  tft.endWrite();
+}
+
+#endif // QR_RENDER_H
@@ -16,6 +16,8 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
 #include <SPI.h>
+#include "RoboEyesProfile.h"
+#include "RoboEyesBatch.h"
 
 // Display colors (16-bit for ST77xx)
 uint16_t BGCOLOR = ST77XX_BLACK; // background and overlays
@@ -149,28 +151,32 @@ public:
   bool sweat = 0;
   byte sweatBorderradius = 3;
 
-  // sweat drops
+  // sweat drops; the first sweat frame reads the maxima before it sets
+  // them, so they start at 0 (a new drop) rather than at whatever was there
   int sweat1XPosInitial = 2;
   int sweat1XPos;
   float sweat1YPos = 2;
-  int sweat1YPosMax;
+  int sweat1YPosMax = 0;
   float sweat1Height = 2;
   float sweat1Width = 1;
 
   int sweat2XPosInitial = 2;
   int sweat2XPos;
   float sweat2YPos = 2;
-  int sweat2YPosMax;
+  int sweat2YPosMax = 0;
   float sweat2Height = 2;
   float sweat2Width = 1;
 
   int sweat3XPosInitial = 2;
   int sweat3XPos;
   float sweat3YPos = 2;
-  int sweat3YPosMax;
+  int sweat3YPosMax = 0;
   float sweat3Height = 2;
   float sweat3Width = 1;
 
+  // Per-stage frame timing (RoboEyesProfile.h; empty unless ROBOEYES_PROFILE)
+  EyeProfiler profiler;
+
   // Constructor
   RoboEyes(AdafruitDisplay &disp) : display(&disp) {
     // nothing
@@ -210,6 +216,12 @@ public:
     frameInterval = 1000 / fps;
   }
 
+  // Per-stage frame timing; all zero unless built with ROBOEYES_PROFILE.
+  // dumpStats() prints them, e.g. to Serial.
+  const EyeFrameStats &getStats() const { return profiler.stats(); }
+  void resetStats(){ profiler.reset(); }
+  template<typename Out> void dumpStats(Out &out) const { profiler.dump(out); }
+
   void setDisplayColors(uint16_t background, uint16_t main) {
     BGCOLOR = background;
     MAINCOLOR = main;
@@ -295,6 +307,8 @@ public:
   void anim_laugh(){ laugh = 1; }
 
   void drawEyes(){
+    profiler.start();
+
     // Pre-calculations
     if(curious){
       if(eyeLxNext<=10) eyeLheightOffset=8; else if (eyeLxNext>=(getScreenConstraint_X()-10) && cyclops) eyeLheightOffset=8; else eyeLheightOffset=0;
@@ -345,11 +359,19 @@ public:
 
     // Draw - clear minimal regions by simply drawing BG first for whole screen
     // (ST7789 is fast on ESP32; if you want further optimization we can use sprites)
+    profiler.lap(EYE_STAGE_UPDATE);
+    // One transaction for the whole frame where the display batches (RoboEyesBatch.h)
+    eyeBatchBegin(*display);
     display->fillScreen(BGCOLOR);
+    profiler.countRect(EYE_STAGE_CLEAR, screenWidth, screenHeight);
+    profiler.lap(EYE_STAGE_CLEAR);
 
     // Draw eyes
     display->fillRoundRect(eyeLx, eyeLy, eyeLwidthCurrent, eyeLheightCurrent, eyeLborderRadiusCurrent, MAINCOLOR);
     if(!cyclops) display->fillRoundRect(eyeRx, eyeRy, eyeRwidthCurrent, eyeRheightCurrent, eyeRborderRadiusCurrent, MAINCOLOR);
+    profiler.countRect(EYE_STAGE_EYES, eyeLwidthCurrent, eyeLheightCurrent);
+    if(!cyclops) profiler.countRect(EYE_STAGE_EYES, eyeRwidthCurrent, eyeRheightCurrent);
+    profiler.lap(EYE_STAGE_EYES);
 
     // Mood transitions
     if(tired){ eyelidsTiredHeightNext = eyeLheightCurrent/2; eyelidsAngryHeightNext = 0; } else { eyelidsTiredHeightNext = 0; }
@@ -381,6 +403,17 @@ public:
     display->fillRoundRect(eyeLx-1, (eyeLy+eyeLheightCurrent)-eyelidsHappyBottomOffset+1, eyeLwidthCurrent+2, eyeLheightDefault, eyeLborderRadiusCurrent, BGCOLOR);
     if(!cyclops) display->fillRoundRect(eyeRx-1, (eyeRy+eyeRheightCurrent)-eyelidsHappyBottomOffset+1, eyeRwidthCurrent+2, eyeRheightDefault, eyeRborderRadiusCurrent, BGCOLOR);
 
+    // Two triangles per lid style (a cyclops' halves add up to one eye), plus the happy lids
+    int lidWidth = cyclops ? eyeLwidthCurrent/2 : eyeLwidthCurrent;
+    int lidWidthR = cyclops ? eyeLwidthCurrent/2 : eyeRwidthCurrent;
+    profiler.countRect(EYE_STAGE_LIDS, lidWidth, eyelidsTiredHeight);
+    profiler.countRect(EYE_STAGE_LIDS, lidWidthR, eyelidsTiredHeight);
+    profiler.countRect(EYE_STAGE_LIDS, lidWidth, eyelidsAngryHeight);
+    profiler.countRect(EYE_STAGE_LIDS, lidWidthR, eyelidsAngryHeight);
+    profiler.countRect(EYE_STAGE_LIDS, eyeLwidthCurrent+2, eyeLheightDefault);
+    if(!cyclops) profiler.countRect(EYE_STAGE_LIDS, eyeRwidthCurrent+2, eyeRheightDefault);
+    profiler.lap(EYE_STAGE_LIDS);
+
     // Sweat
     if(sweat){
       if(sweat1YPos <= sweat1YPosMax) sweat1YPos += 0.5; else { sweat1XPosInitial = random(30); sweat1YPos = 2; sweat1YPosMax = (random(10)+10); sweat1Width = 1; sweat1Height = 2; }
@@ -397,7 +430,16 @@ public:
       if(sweat3YPos <= sweat3YPosMax/2) { sweat3Width += 0.5; sweat3Height += 0.5; } else { sweat3Width -= 0.1; sweat3Height -= 0.5; }
       sweat3XPos = sweat3XPosInitial - (sweat3Width/2);
       display->fillRoundRect(sweat3XPos, sweat3YPos, (int)sweat3Width, (int)sweat3Height, sweatBorderradius, MAINCOLOR);
-    }  }
+      profiler.countRect(EYE_STAGE_SWEAT, (int)sweat1Width, (int)sweat1Height);
+      profiler.countRect(EYE_STAGE_SWEAT, (int)sweat2Width, (int)sweat2Height);
+      profiler.countRect(EYE_STAGE_SWEAT, (int)sweat3Width, (int)sweat3Height);
+    }
+    profiler.lap(EYE_STAGE_SWEAT);
+    eyeBatchEnd(*display);
+
+    // Drawn straight to the panel: there is no flush stage
+    profiler.endFrame(frameInterval);
+  }
 
 };
 
@@ -4,12 +4,26 @@
 
 #include "RoboEyes.h"
 
+// Shake left/right, then up/down: 3 x 200 ms, one step of 15 px each way
+static const EyeKeyframe SHAKE_KEYS[] PROGMEM = {
+  {   0,  15, EASE_STEP },
+  { 100, -15, EASE_STEP }
+};
+static const EyeTrack CONFUSED_TRACKS[] PROGMEM = { EYE_TRACK(ANIM_X, SHAKE_KEYS) };
+static const EyeTrack LAUGH_TRACKS[] PROGMEM = { EYE_TRACK(ANIM_Y, SHAKE_KEYS) };
+static const EyeClip CLIP_CONFUSED PROGMEM = EYE_CLIP(200, 2, CONFUSED_TRACKS);
+static const EyeClip CLIP_LAUGH PROGMEM = EYE_CLIP(200, 2, LAUGH_TRACKS);
+
 RoboEyes::RoboEyes(Adafruit_ST7789 &display) 
   : _display(display),
     _screenWidth(240),
     _screenHeight(320),
     _maxFPS(30),
     _lastFrameTime(0),
+    _timeSource(NULL),
+    _lastUpdateTime(0),
+    _stepAccumulator(0),
+    _simTime(0),
     _spaceBetween(20),
     _isCyclops(false),
     _currentMood(MOOD_DEFAULT),
@@ -18,6 +32,8 @@ RoboEyes::RoboEyes(Adafruit_ST7789 &display)
     _sweat(false),
     _colorBg(ST77XX_BLACK),
     _colorMain(ST77XX_CYAN),
+    _colorBgSet(ST77XX_BLACK),
+    _colorMainSet(ST77XX_CYAN),
     _autoBlinkEnabled(true),
     _blinkInterval(3000),
     _blinkVariation(2000),
@@ -28,7 +44,9 @@ RoboEyes::RoboEyes(Adafruit_ST7789 &display)
     _lastIdleTime(0),
     _isBlinking(false),
     _blinkStartTime(0),
-    _blinkDuration(200)
+    _blinkDuration(200),
+    _canvas(NULL),
+    _pixels(display)
 {
   // Initialize left eye
   _leftEye.width = 40;
@@ -45,6 +63,10 @@ RoboEyes::RoboEyes(Adafruit_ST7789 &display)
   _leftEye.prevX = _leftEye.x;
   _leftEye.prevY = _leftEye.y;
   _leftEye.prevOpenAmount = _leftEye.openAmount;
+  _leftEye.prevWidth = 0;
+  _leftEye.prevHeight = 0;
+  _leftEye.prevRadius = 0;
+  _leftEye.prevPlain = false;
   
   // Initialize right eye
   _rightEye = _leftEye;
@@ -53,6 +75,10 @@ RoboEyes::RoboEyes(Adafruit_ST7789 &display)
   _rightEye.prevOpenAmount = _rightEye.openAmount;
 }
 
+RoboEyes::~RoboEyes() {
+  delete _canvas;
+}
+
 void RoboEyes::begin(uint16_t screenWidth, uint16_t screenHeight, uint8_t maxFPS) {
   _screenWidth = screenWidth;
   _screenHeight = screenHeight;
@@ -69,8 +95,14 @@ void RoboEyes::begin(uint16_t screenWidth, uint16_t screenHeight, uint8_t maxFPS
   _rightEye.targetX = _rightEye.x;
   _rightEye.targetY = _rightEye.y;
   
-  _lastBlinkTime = millis();
-  _lastIdleTime = millis();
+  // Corner rows for moved eyes; larger radii still work, a little slower
+  _corners.begin(32);
+  
+  _lastUpdateTime = now();
+  _stepAccumulator = 0;
+  _simTime = _lastUpdateTime;
+  _lastBlinkTime = _simTime;
+  _lastIdleTime = _simTime;
 
   // Ensure initial screen is cleared to the background color to avoid
   // leftover pixels from previous runs or bootloader output.
@@ -78,51 +110,83 @@ void RoboEyes::begin(uint16_t screenWidth, uint16_t screenHeight, uint8_t maxFPS
 }
 
 void RoboEyes::update() {
-  // Frame rate limiting
-  unsigned long currentTime = millis();
-  unsigned long frameDelay = 1000 / _maxFPS;
+  // Read the clock once and catch the simulation up in fixed steps
+  unsigned long currentTime = now();
+  _profiler.start();
+  _stepAccumulator += currentTime - _lastUpdateTime;
+  _lastUpdateTime = currentTime;
   
-  if (currentTime - _lastFrameTime < frameDelay) {
+  uint8_t steps = 0;
+  while (_stepAccumulator >= ROBOEYES_STEP_MS) {
+    if (steps == ROBOEYES_MAX_CATCHUP_STEPS) {
+      // Blocked for too long: drop the backlog rather than spiral
+      _stepAccumulator = 0;
+      break;
+    }
+    _simTime += ROBOEYES_STEP_MS;
+    _stepAccumulator -= ROBOEYES_STEP_MS;
+    step();
+    steps++;
+  }
+  
+  // Frame rate limiting: only the latest state is drawn, and only if it moved on.
+  // A late frame therefore skips drawing but never slows the motion down.
+  _profiler.lap(EYE_STAGE_UPDATE);
+  if (steps == 0 || currentTime - _lastFrameTime < 1000UL / _maxFPS) {
+    _profiler.end();
     return;
   }
   _lastFrameTime = currentTime;
   
+  drawEyes();
+  _profiler.endFrame(1000UL / _maxFPS);
+}
+
+void RoboEyes::step() {
   // Update behaviors
   updateAutoBehaviors();
   
   // Update eye states
   updateEyePositions();
   updateEyeOpenAmount();
-  
-  // Draw
-  drawEyes();
+  _timeline.update(_simTime);
 }
 
 void RoboEyes::drawEyes() {
   // Draw each eye using minimal dirty rectangles computed from previous
-  // and current positions. drawSingleEye will clear only the union box
-  // and then draw the new eye.
-
-  if (!_isCyclops) {
-    drawSingleEye(_leftEye);
-    drawSingleEye(_rightEye);
-  } else {
-    // Cyclops mode - temporarily draw left eye centered and update its prev
-    int16_t origX = _leftEye.x;
-    _leftEye.x = _screenWidth / 2;
-    drawSingleEye(_leftEye);
-    // Keep logical position unchanged
-    _leftEye.x = origX;
+  // and current positions: drawDirect() clears only the union boxes (or,
+  // for an eye that just moved, writes only its changed edges).
+
+  // Cyclops mode and animation offsets move the eyes only while drawing;
+  // prev values record where they were drawn
+  int16_t origLX = _leftEye.x, origLY = _leftEye.y;
+  int16_t origRX = _rightEye.x, origRY = _rightEye.y;
+  if (_isCyclops) _leftEye.x = _screenWidth / 2;
+  int16_t dx = _timeline.value(ANIM_X);
+  int16_t dy = _timeline.value(ANIM_Y);
+  _leftEye.x += dx;
+  _leftEye.y += dy;
+  _rightEye.x += dx;
+  _rightEye.y += dy;
+  Eye *eyes[2] = { &_leftEye, &_rightEye };
+  uint8_t eyeCount = _isCyclops ? 1 : 2;
+  int16_t sweatY = 20 + ((_simTime / 100) % 10);
+
+  // Compositing renders the same dirty areas off-screen; if the canvas can't
+  // take this frame, fall through to the direct path below.
+  if (!_canvas || !composeFrame(eyes, eyeCount, sweatY)) {
+    drawDirect(eyes, eyeCount, sweatY);
   }
 
-  // Sweat: clear only a small area and draw
-  if (_sweat) {
-    int16_t sweatX = _screenWidth / 2 - 30;
-    int16_t sweatY = 20 + ((millis() / 100) % 10);
-    _display.fillRect(sweatX - 6, sweatY - 6, 24, 24, _colorBg);
-    _display.fillCircle(sweatX, sweatY, 3, _colorMain);
-    _display.fillCircle(sweatX, sweatY + 8, 4, _colorMain);
-  }
+  // Keep logical positions unchanged
+  _leftEye.x = origLX;
+  _leftEye.y = origLY;
+  _rightEye.x = origRX;
+  _rightEye.y = origRY;
+}
+
+void RoboEyes::setTimeSource(RoboEyesTimeSource source) {
+  _timeSource = source;
 }
 
 void RoboEyes::setWidth(uint8_t leftEye, uint8_t rightEye) {
@@ -190,7 +254,7 @@ void RoboEyes::close(bool leftEye, bool rightEye) {
 void RoboEyes::blink(bool leftEye, bool rightEye) {
   if (!_isBlinking) {
     _isBlinking = true;
-    _blinkStartTime = millis();
+    _blinkStartTime = _simTime;
     
     if (leftEye) _leftEye.targetOpen = 0.0;
     if (rightEye) _rightEye.targetOpen = 0.0;
@@ -198,29 +262,15 @@ void RoboEyes::blink(bool leftEye, bool rightEye) {
 }
 
 void RoboEyes::anim_confused() {
-  // Shake left and right quickly
-  for (int i = 0; i < 3; i++) {
-    setPosition(POS_E);
-    delay(100);
-    drawEyes();
-    setPosition(POS_W);
-    delay(100);
-    drawEyes();
-  }
+  // Shake left and right quickly, ending up looking ahead as before
   setPosition(POS_DEFAULT);
+  play(&CLIP_CONFUSED);
 }
 
 void RoboEyes::anim_laugh() {
-  // Shake up and down
-  for (int i = 0; i < 3; i++) {
-    setPosition(POS_N);
-    delay(100);
-    drawEyes();
-    setPosition(POS_S);
-    delay(100);
-    drawEyes();
-  }
+  // Shake up and down, ending up looking ahead as before
   setPosition(POS_DEFAULT);
+  play(&CLIP_LAUGH);
 }
 
 void RoboEyes::setAutoBlinker(bool enable, uint16_t interval, uint16_t variation) {
@@ -236,15 +286,49 @@ void RoboEyes::setIdleMode(bool enable, uint16_t interval, uint16_t variation) {
 }
 
 void RoboEyes::setColors(uint16_t background, uint16_t main) {
-  _colorBg = background;
-  _colorMain = main;
+  _colorBgSet = background;
+  _colorMainSet = main;
+  _colorBg = _pixels.quantize(background);
+  _colorMain = _pixels.quantize(main);
+  // Moved eyes only send their edges; repaint them whole in the new colours
+  _leftEye.prevPlain = false;
+  _rightEye.prevPlain = false;
+}
+
+void RoboEyes::setPixelFormat(EyePixelFormat format) {
+  _pixels.setFormat(format);
+  setColors(_colorBgSet, _colorMainSet);
+}
+
+bool RoboEyes::setCompositing(bool enable, uint32_t maxPixels, bool indexed) {
+  delete _canvas;
+  _canvas = NULL;
+  if (!enable) return true;
+
+  if (maxPixels == 0) {
+    maxPixels = ROBOEYES_CANVAS_MAX_PIXELS;
+#if defined(ESP32)
+    // With PSRAM the whole screen fits, so every frame is one window
+    if (psramFound()) maxPixels = (uint32_t)_screenWidth * _screenHeight;
+#endif
+    // At 1 bit per pixel it fits everywhere
+    if (indexed) maxPixels = (uint32_t)_screenWidth * _screenHeight;
+  }
+
+  _canvas = new RoboEyesCanvas(_screenWidth, _screenHeight, indexed);
+  if (!_canvas->reserve(maxPixels)) {
+    delete _canvas;
+    _canvas = NULL;
+    return false;
+  }
+  return true;
 }
 
 // ========== Internal Methods ==========
 
 void RoboEyes::updateEyePositions() {
   // Smooth movement using easing
-  float speed = 0.15; // Movement speed (0.0 - 1.0)
+  EyeReal speed = 0.15; // Movement speed (0.0 - 1.0)
   
   _leftEye.x += (_leftEye.targetX - _leftEye.x) * speed;
   _leftEye.y += (_leftEye.targetY - _leftEye.y) * speed;
@@ -254,23 +338,23 @@ void RoboEyes::updateEyePositions() {
 }
 
 void RoboEyes::updateEyeOpenAmount() {
-  float speed = 0.2;
+  EyeReal speed = 0.2;
   
   _leftEye.openAmount += (_leftEye.targetOpen - _leftEye.openAmount) * speed;
   _rightEye.openAmount += (_rightEye.targetOpen - _rightEye.openAmount) * speed;
   
   // Handle blink animation
   if (_isBlinking) {
-    unsigned long elapsed = millis() - _blinkStartTime;
+    unsigned long elapsed = _simTime - _blinkStartTime;
     
     if (elapsed < _blinkDuration / 2) {
       // Closing
-      float progress = (float)elapsed / (_blinkDuration / 2);
+      EyeReal progress = EyeReal(elapsed) / (_blinkDuration / 2);
       _leftEye.openAmount = 1.0 - progress;
       _rightEye.openAmount = 1.0 - progress;
     } else if (elapsed < _blinkDuration) {
       // Opening
-      float progress = (float)(elapsed - _blinkDuration / 2) / (_blinkDuration / 2);
+      EyeReal progress = EyeReal(elapsed - _blinkDuration / 2) / (_blinkDuration / 2);
       _leftEye.openAmount = progress;
       _rightEye.openAmount = progress;
     } else {
@@ -285,16 +369,12 @@ void RoboEyes::updateEyeOpenAmount() {
 }
 
 void RoboEyes::updateAutoBehaviors() {
-  unsigned long currentTime = millis();
+  unsigned long currentTime = _simTime;
   
   // Auto blink
   if (_autoBlinkEnabled && !_isBlinking) {
     unsigned long nextBlink = _lastBlinkTime + _blinkInterval + random(_blinkVariation);
     if (currentTime > nextBlink) {
-      // Debug: indicate auto-blink triggered (useful to diagnose rapid blinking)
-      Serial.print("[RoboEyes] Auto blink triggered at ");
-      Serial.println(currentTime);
-
       blink(true, true);
       // Set last blink time to include blink duration as a short refractory period
       // This avoids immediate re-triggering in edge cases where timing math or
@@ -315,53 +395,33 @@ void RoboEyes::updateAutoBehaviors() {
   }
 }
 
+// Eye shape per mood, indexed by Mood. Lid angles in hundredths.
+struct MoodShape {
+  int8_t upperLid, lowerLid;
+  uint8_t height, width, borderRadius;
+};
+
+static const MoodShape MOOD_SHAPES[] PROGMEM = {
+  {   0,   0, 50, 40, 15 },  // MOOD_DEFAULT
+  { -28,  28, 36, 40, 12 },  // MOOD_HAPPY
+  {  32, -28, 38, 40, 10 },  // MOOD_SAD
+  { -48, -18, 34, 38,  8 },  // MOOD_ANGRY
+  {   8, -10, 20, 40,  6 }   // MOOD_TIRED
+};
+
 void RoboEyes::applyMoodToEye(Eye &eye) {
-  switch (_currentMood) {
-    case MOOD_HAPPY:
-      eye.upperLidAngle = -0.28;
-      eye.lowerLidAngle = 0.28;
-      eye.height = 36;
-      eye.width = 40;
-      eye.borderRadius = 12;
-      break;
-    
-    case MOOD_SAD:
-      eye.upperLidAngle = 0.32;
-      eye.lowerLidAngle = -0.28;
-      eye.height = 38;
-      eye.width = 40;
-      eye.borderRadius = 10;
-      break;
-    
-    case MOOD_ANGRY:
-      eye.upperLidAngle = -0.48;
-      eye.lowerLidAngle = -0.18;
-      eye.height = 34;
-      eye.width = 38;
-      eye.borderRadius = 8;
-      break;
-    
-    case MOOD_TIRED:
-      eye.upperLidAngle = 0.08;
-      eye.lowerLidAngle = -0.1;
-      eye.height = 20;
-      eye.width = 40;
-      eye.borderRadius = 6;
-      break;
-    
-    case MOOD_DEFAULT:
-    default:
-      eye.upperLidAngle = 0.0;
-      eye.lowerLidAngle = 0.0;
-      eye.height = 50;
-      eye.width = 40;
-      eye.borderRadius = 15;
-      break;
-  }
+  MoodShape m;
+  uint8_t row = _currentMood < sizeof(MOOD_SHAPES) / sizeof(MOOD_SHAPES[0]) ? _currentMood : MOOD_DEFAULT;
+  memcpy_P(&m, &MOOD_SHAPES[row], sizeof(m));
+  eye.upperLidAngle = EyeReal(m.upperLid) / 100;
+  eye.lowerLidAngle = EyeReal(m.lowerLid) / 100;
+  eye.height = m.height;
+  eye.width = m.width;
+  eye.borderRadius = m.borderRadius;
 }
 
-void RoboEyes::drawSingleEye(Eye &eye) {
-  // Compute current and previous bounding rects and clear only their union.
+bool RoboEyes::eyeDirtyRect(const Eye &eye, int16_t &ux, int16_t &uy, int16_t &uw, int16_t &uh) {
+  // Compute current and previous bounding rects and return their union.
   // Compute a margin that safely covers rounded corners and lid lines.
   // Use the eye borderRadius as a basis and add a small safety padding.
   int16_t margin = eye.borderRadius + 6;
@@ -381,12 +441,12 @@ void RoboEyes::drawSingleEye(Eye &eye) {
   int16_t hPrevBox = (hPrev < 2 ? 2 : hPrev) + margin * 2;
 
   // Union rectangle
-  int16_t ux = xCurr < xPrev ? xCurr : xPrev;
-  int16_t uy = yCurr < yPrev ? yCurr : yPrev;
+  ux = xCurr < xPrev ? xCurr : xPrev;
+  uy = yCurr < yPrev ? yCurr : yPrev;
   int16_t ux2 = (xCurr + wCurrBox) > (xPrev + wPrevBox) ? (xCurr + wCurrBox) : (xPrev + wPrevBox);
   int16_t uy2 = (yCurr + hCurrBox) > (yPrev + hPrevBox) ? (yCurr + hCurrBox) : (yPrev + hPrevBox);
-  int16_t uw = ux2 - ux;
-  int16_t uh = uy2 - uy;
+  uw = ux2 - ux;
+  uh = uy2 - uy;
 
   // Clamp to screen
   if (ux < 0) { uw += ux; ux = 0; }
@@ -394,61 +454,251 @@ void RoboEyes::drawSingleEye(Eye &eye) {
   if (ux + uw > _screenWidth) uw = _screenWidth - ux;
   if (uy + uh > _screenHeight) uh = _screenHeight - uy;
 
-  if (uw > 0 && uh > 0) {
-    _display.fillRect(ux, uy, uw, uh, _colorBg);
+  return uw > 0 && uh > 0;
+}
+
+void RoboEyes::drawDirect(Eye *eyes[], uint8_t eyeCount, int16_t sweatY) {
+  // An eye with the same plain shape as last frame only needs the edges that
+  // changed; the others clear the union of their old and new box and redraw.
+  bool moved[2];
+  DirtyRect box[2];
+  for (uint8_t i = 0; i < eyeCount; i++) {
+    Eye &eye = *eyes[i];
+    uint8_t h = (uint8_t)(eye.height * eye.openAmount);
+    moved[i] = eye.prevPlain && isPlain(eye, h) && eye.width == eye.prevWidth &&
+               h == eye.prevHeight && eye.borderRadius == eye.prevRadius;
+    DirtyRect now = { (int16_t)(eye.x - eye.width / 2), (int16_t)(eye.y - h / 2), eye.width, h };
+    DirtyRect was = { (int16_t)(eye.prevX - eye.prevWidth / 2), (int16_t)(eye.prevY - eye.prevHeight / 2),
+                      eye.prevWidth, eye.prevHeight };
+    box[i] = now;
+    box[i].unite(was);
   }
+  if (eyeCount == 2 && box[0].intersects(box[1])) moved[0] = moved[1] = false;
+
+  // Every clear goes out before any eye is drawn, so no clear cuts into an
+  // eye drawn earlier in the frame. A moving eye under a clear redraws too.
+  DirtyRect cleared[3];
+  uint8_t clearCount;
+  bool settled = false;
+  while (!settled) {
+    clearCount = 0;
+    for (uint8_t i = 0; i < eyeCount; i++) {
+      DirtyRect &c = cleared[clearCount];
+      if (!moved[i] && eyeDirtyRect(*eyes[i], c.x, c.y, c.w, c.h)) clearCount++;
+    }
+    if (_sweat) {
+      DirtyRect sweatBox = { (int16_t)(_screenWidth / 2 - 36), (int16_t)(sweatY - 6), 24, 24 };
+      cleared[clearCount++] = sweatBox;
+    }
+    settled = true;
+    for (uint8_t i = 0; i < eyeCount; i++) {
+      for (uint8_t c = 0; c < clearCount && moved[i]; c++) {
+        if (cleared[c].intersects(box[i])) moved[i] = settled = false;
+      }
+    }
+  }
+
+  for (uint8_t c = 0; c < clearCount; c++) {
+    _display.fillRect(cleared[c].x, cleared[c].y, cleared[c].w, cleared[c].h, _colorBg);
+    _profiler.countRect(EYE_STAGE_CLEAR, cleared[c].w, cleared[c].h);
+  }
+  _profiler.lap(EYE_STAGE_CLEAR);
 
-  // Draw the eye into the cleared area
-  drawEyeShape(eye.x, eye.y, eye);
+  for (uint8_t i = 0; i < eyeCount; i++) {
+    Eye &eye = *eyes[i];
+    if (moved[i]) moveEye(eye, eye.width, eye.prevHeight, eye.borderRadius);
+    else drawEyeShape(_display, eye.x, eye.y, eye);
+    rememberDrawn(eye);
+  }
+
+  if (_sweat) {
+    drawSweat(_display, _screenWidth / 2 - 30, sweatY);
+  }
+}
 
-  // Update previous values for next frame
+bool RoboEyes::isPlain(const Eye &eye, uint8_t h) const {
+  return h >= 2 && abs(eye.upperLidAngle) < 0.1 && abs(eye.lowerLidAngle) < 0.1;
+}
+
+void RoboEyes::moveEye(const Eye &eye, uint8_t w, uint8_t h, uint8_t r) {
+  int16_t ox = eye.prevX - w / 2, oy = eye.prevY - h / 2;
+  int16_t nx = eye.x - w / 2, ny = eye.y - h / 2;
+  if (ox == nx && oy == ny) return;
+
+  // Row by row: background where the eye left, main colour where it arrived
+  uint32_t pixels = 0;
+  int16_t top = oy < ny ? oy : ny;
+  int16_t bottom = (oy > ny ? oy : ny) + h;
+  _display.startWrite();
+  for (int16_t row = top; row < bottom; row++) {
+    int16_t o0 = 0, o1 = 0, n0 = 0, n1 = 0;
+    eyeRow(ox, oy, w, h, r, row, o0, o1);
+    eyeRow(nx, ny, w, h, r, row, n0, n1);
+    writeOutside(row, o0, o1, n0, n1, _colorBg);
+    writeOutside(row, n0, n1, o0, o1, _colorMain);
+    pixels += (o1 - o0) + (n1 - n0) - 2 * max(0, min(o1, n1) - max(o0, n0));
+  }
+  _display.endWrite();
+  _profiler.count(EYE_STAGE_EYES, 1, pixels);
+  _profiler.lap(EYE_STAGE_EYES);
+}
+
+// Pixels [x0, x1) of row covered by fillRoundRect(x, y, w, h, r)
+bool RoboEyes::eyeRow(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                      int16_t row, int16_t &x0, int16_t &x1) const {
+  if (row < y || row >= y + h) return false;
+  int16_t maxRadius = ((w < h) ? w : h) / 2;
+  if (r > maxRadius) r = maxRadius;
+  int16_t d = min((int16_t)(row - y), (int16_t)(y + h - 1 - row));
+  int16_t inset = _corners.inset(r, d);
+  x0 = x + inset;
+  x1 = x + w - inset;
+  return x0 < x1;
+}
+
+// The part of [a0, a1) outside [b0, b1)
+void RoboEyes::writeOutside(int16_t row, int16_t a0, int16_t a1, int16_t b0, int16_t b1, uint16_t color) {
+  if (a0 >= a1) return;
+  if (b0 >= b1 || b1 <= a0 || b0 >= a1) {
+    _display.writeFastHLine(a0, row, a1 - a0, color);
+    return;
+  }
+  if (a0 < b0) _display.writeFastHLine(a0, row, b0 - a0, color);
+  if (b1 < a1) _display.writeFastHLine(b1, row, a1 - b1, color);
+}
+
+void RoboEyes::rememberDrawn(Eye &eye) {
   eye.prevX = eye.x;
   eye.prevY = eye.y;
   eye.prevOpenAmount = eye.openAmount;
+  eye.prevWidth = eye.width;
+  eye.prevHeight = (uint8_t)(eye.height * eye.openAmount);
+  eye.prevRadius = eye.borderRadius;
+  eye.prevPlain = isPlain(eye, eye.prevHeight);
+}
+
+bool RoboEyes::composeFrame(Eye *eyes[], uint8_t eyeCount, int16_t sweatY) {
+  // Dirty areas of this frame: one per eye, plus the sweat box
+  int16_t rx[3], ry[3], rw[3], rh[3];
+  uint8_t n = 0;
+  for (uint8_t i = 0; i < eyeCount; i++) {
+    if (eyeDirtyRect(*eyes[i], rx[n], ry[n], rw[n], rh[n])) n++;
+  }
+  if (_sweat) {
+    rx[n] = _screenWidth / 2 - 36;
+    ry[n] = sweatY - 6;
+    rw[n] = 24;
+    rh[n] = 24;
+    n++;
+  }
+  if (n == 0) return true;
+
+  // Preferred: the bounding box of everything in one window
+  int16_t bx = rx[0], by = ry[0], bx2 = rx[0] + rw[0], by2 = ry[0] + rh[0];
+  for (uint8_t i = 1; i < n; i++) {
+    if (rx[i] < bx) bx = rx[i];
+    if (ry[i] < by) by = ry[i];
+    if (rx[i] + rw[i] > bx2) bx2 = rx[i] + rw[i];
+    if (ry[i] + rh[i] > by2) by2 = ry[i] + rh[i];
+  }
+  if (bx < 0) bx = 0;
+  if (by < 0) by = 0;
+  if (bx2 > _screenWidth) bx2 = _screenWidth;
+  if (by2 > _screenHeight) by2 = _screenHeight;
+
+  if (!composeRegion(eyes, eyeCount, sweatY, bx, by, bx2 - bx, by2 - by)) {
+    // Too big for the canvas: one window per dirty area instead. Every
+    // area must fit, otherwise nothing is drawn and the caller goes direct.
+    for (uint8_t i = 0; i < n; i++) {
+      if (!_canvas->fits(rw[i], rh[i])) return false;
+    }
+    for (uint8_t i = 0; i < n; i++) {
+      composeRegion(eyes, eyeCount, sweatY, rx[i], ry[i], rw[i], rh[i]);
+    }
+  }
+
+  for (uint8_t i = 0; i < eyeCount; i++) {
+    rememberDrawn(*eyes[i]);
+  }
+  return true;
+}
+
+bool RoboEyes::composeRegion(Eye *eyes[], uint8_t eyeCount, int16_t sweatY,
+                             int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (!_canvas->setViewport(x, y, w, h)) return false;
+
+  // Everything that can touch the region; the canvas clips the rest
+  _canvas->setPalette(_colorBg, _colorMain);
+  _canvas->fillScreen(_colorBg);
+  _profiler.countRect(EYE_STAGE_CLEAR, w, h);
+  _profiler.lap(EYE_STAGE_CLEAR);
+  for (uint8_t i = 0; i < eyeCount; i++) {
+    drawEyeShape(*_canvas, eyes[i]->x, eyes[i]->y, *eyes[i]);
+  }
+  if (_sweat) {
+    drawSweat(*_canvas, _screenWidth / 2 - 30, sweatY);
+  }
+
+  _canvas->flush(_pixels);
+  _profiler.countRect(EYE_STAGE_FLUSH, w, h);
+  _profiler.lap(EYE_STAGE_FLUSH);
+  return true;
 }
 
-void RoboEyes::drawEyeShape(int16_t centerX, int16_t centerY, Eye &eye) {
+void RoboEyes::drawEyeShape(Adafruit_GFX &gfx, int16_t centerX, int16_t centerY, Eye &eye) {
   uint8_t w = eye.width;
-  uint8_t h = eye.height * eye.openAmount;
+  uint8_t h = (uint8_t)(eye.height * eye.openAmount);
   uint8_t r = eye.borderRadius;
   
   if (h < 2) return; // Eye closed
   
   // Apply mood angle to lid
-  float upperAngle = eye.upperLidAngle;
-  float lowerAngle = eye.lowerLidAngle;
+  EyeReal upperAngle = eye.upperLidAngle;
+  EyeReal lowerAngle = eye.lowerLidAngle;
   
   // Draw filled rounded rectangle
   int16_t x = centerX - w / 2;
   int16_t y = centerY - h / 2;
   
   // Adjust for lid angles
-  int16_t deltaTopLeft = upperAngle * w / 2;
-  int16_t deltaTopRight = -upperAngle * w / 2;
-  int16_t deltaBottomLeft = lowerAngle * w / 2;
-  int16_t deltaBottomRight = -lowerAngle * w / 2;
+  int16_t deltaTopLeft = (int16_t)(upperAngle * w / 2);
+  int16_t deltaTopRight = (int16_t)(-upperAngle * w / 2);
+  int16_t deltaBottomLeft = (int16_t)(lowerAngle * w / 2);
+  int16_t deltaBottomRight = (int16_t)(-lowerAngle * w / 2);
   
   // Simple filled rounded rect (approximation)
-  _display.fillRoundRect(x, y, w, h, r, _colorMain);
+  gfx.fillRoundRect(x, y, w, h, r, _colorMain);
+  _profiler.countRect(EYE_STAGE_EYES, w, h);
+  _profiler.lap(EYE_STAGE_EYES);
   
   // Add lid lines for mood
-  if (abs(upperAngle) > 0.1 || abs(lowerAngle) > 0.1) {
+  if (abs(upperAngle) >= 0.1 || abs(lowerAngle) >= 0.1) {
     // Top lid
-    _display.drawLine(
+    gfx.drawLine(
       x, y + deltaTopLeft,
       x + w, y + deltaTopRight,
       _colorMain
     );
     
     // Bottom lid
-    _display.drawLine(
+    gfx.drawLine(
       x, y + h + deltaBottomLeft,
       x + w, y + h + deltaBottomRight,
       _colorMain
     );
+    _profiler.count(EYE_STAGE_LIDS, 2, 2 * (w + 1));
+    _profiler.lap(EYE_STAGE_LIDS);
   }
 }
 
+void RoboEyes::drawSweat(Adafruit_GFX &gfx, int16_t sweatX, int16_t sweatY) {
+  gfx.fillCircle(sweatX, sweatY, 3, _colorMain);
+  gfx.fillCircle(sweatX, sweatY + 8, 4, _colorMain);
+  _profiler.countRect(EYE_STAGE_SWEAT, 7, 7);
+  _profiler.countRect(EYE_STAGE_SWEAT, 9, 9);
+  _profiler.lap(EYE_STAGE_SWEAT);
+}
+
 void RoboEyes::calculateTargetPosition(Position pos, int16_t &leftX, int16_t &leftY, int16_t &rightX, int16_t &rightY) {
   int16_t centerX = _screenWidth / 2;
   int16_t centerY = _screenHeight / 2;
@@ -482,6 +732,8 @@ void RoboEyes::calculateTargetPosition(Position pos, int16_t &leftX, int16_t &le
   }
 }
 
-float RoboEyes::easeInOutCubic(float t) {
-  return t < 0.5 ? 4 * t * t * t : 1 - pow(-2 * t + 2, 3) / 2;
+EyeReal RoboEyes::easeInOutCubic(EyeReal t) {
+  if (t < 0.5) return 4 * t * t * t;
+  EyeReal u = -2 * t + 2;
+  return 1 - u * u * u / 2;
 }
@@ -10,6 +10,33 @@
 #include <Arduino.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
+#include "RoboEyesCanvas.h"
+#include "RoboEyesCorners.h"
+#include "RoboEyesDirty.h"
+#include "RoboEyesFixed.h"
+#include "RoboEyesTimeline.h"
+#include "RoboEyesProfile.h"
+#include "RoboEyesPixels.h"
+
+// Pixel budget for the off-screen canvas when there is no PSRAM
+// (16K pixels = 32 KB, enough for both eyes in one window at default sizes)
+#ifndef ROBOEYES_CANVAS_MAX_PIXELS
+#define ROBOEYES_CANVAS_MAX_PIXELS 16384
+#endif
+
+// Simulation step in ms. Motion, easing and timers advance in steps of this
+// size whatever frame rate is achieved (easing factors were tuned for 30 FPS).
+#ifndef ROBOEYES_STEP_MS
+#define ROBOEYES_STEP_MS 33
+#endif
+
+// Most steps update() catches up on after a stall; older backlog is dropped
+#ifndef ROBOEYES_MAX_CATCHUP_STEPS
+#define ROBOEYES_MAX_CATCHUP_STEPS 30
+#endif
+
+// Millisecond clock used by RoboEyes (defaults to millis())
+typedef unsigned long (*RoboEyesTimeSource)();
 
 // Mood types
 enum Mood {
@@ -20,6 +47,13 @@ enum Mood {
   MOOD_TIRED
 };
 
+// Parameters a clip can animate: pixel offsets added to both eyes
+enum AnimParam {
+  ANIM_X,
+  ANIM_Y,
+  ANIM_PARAM_COUNT
+};
+
 // Position types (8 directions + center)
 enum Position {
   POS_DEFAULT,  // Center
@@ -36,14 +70,22 @@ enum Position {
 class RoboEyes {
 public:
   RoboEyes(Adafruit_ST7789 &display);
+  ~RoboEyes();
   
   // Initialization
   void begin(uint16_t screenWidth, uint16_t screenHeight, uint8_t maxFPS = 30);
   
   // Update & Draw
+  // update() steps the simulation to the current time in fixed
+  // ROBOEYES_STEP_MS steps, then draws the latest state (at most maxFPS)
   void update();
   void drawEyes();
   
+  // Time source, e.g. a virtual clock for off-device runs. NULL = millis().
+  // Call before begin().
+  void setTimeSource(RoboEyesTimeSource source);
+  unsigned long simTime() const { return _simTime; }
+  
   // Eye shape configuration
   void setWidth(uint8_t leftEye, uint8_t rightEye);
   void setHeight(uint8_t leftEye, uint8_t rightEye);
@@ -62,17 +104,46 @@ public:
   void close(bool leftEye = true, bool rightEye = true);
   
   // Animations
+  // Clips run on the simulation clock: play() layers a clip over whatever is
+  // playing, queue() starts it when everything before it is done. Both return
+  // at once (false if no layer or queue slot is free).
   void blink(bool leftEye = true, bool rightEye = true);
   void anim_confused();
   void anim_laugh();
+  bool play(const EyeClip *clip) { return _timeline.play(clip, _simTime); }
+  bool queue(const EyeClip *clip) { return _timeline.queue(clip); }
+  void stopAnimations() { _timeline.stop(); }
+  bool isAnimating() const { return _timeline.active(); }
   
   // Auto behaviors
   void setAutoBlinker(bool enable, uint16_t interval = 3, uint16_t variation = 2);
   void setIdleMode(bool enable, uint16_t interval = 5, uint16_t variation = 3);
   
-  // Display colors
+  // Display colors, stored as the pixel format shows them
   void setColors(uint16_t background, uint16_t main);
   
+  // EYE_PIXELS_RGB444 pushes composited frames as 12-bit pixels, two in
+  // three bytes (a quarter less SPI traffic), and quantizes the colours to
+  // match. Direct drawing stays RGB565; the panel is switched back after
+  // every push.
+  void setPixelFormat(EyePixelFormat format);
+  
+  // Off-screen compositing: render each frame into RAM and push it with a
+  // single address window instead of one SPI transaction per primitive.
+  // Call after begin(). maxPixels = 0 uses the full screen with PSRAM,
+  // else ROBOEYES_CANVAS_MAX_PIXELS. indexed stores the two-colour face at
+  // 1 bit per pixel, expanded while it is pushed: the full screen (the
+  // default then) takes 9.6 KB, so every board composites whole frames.
+  // Returns false (and keeps drawing directly) if no buffer could be allocated.
+  bool setCompositing(bool enable, uint32_t maxPixels = 0, bool indexed = false);
+  bool isCompositing() const { return _canvas != NULL; }
+  
+  // Per-stage frame timing, see RoboEyesProfile.h (all zero unless built
+  // with ROBOEYES_PROFILE). dumpStats() prints them, e.g. to Serial.
+  const EyeFrameStats &getStats() const { return _profiler.stats(); }
+  void resetStats() { _profiler.reset(); }
+  template<typename Out> void dumpStats(Out &out) const { _profiler.dump(out); }
+  
   // Public access to state (for demo purposes)
   bool _curiosity;
   bool _isCyclops;
@@ -88,6 +159,12 @@ private:
   uint8_t _maxFPS;
   unsigned long _lastFrameTime;
   
+  // Fixed-timestep clock
+  RoboEyesTimeSource _timeSource;
+  unsigned long _lastUpdateTime;
+  unsigned long _stepAccumulator;
+  unsigned long _simTime;         // time of the last simulated step
+  
   // Eye properties
   struct Eye {
     uint8_t width;
@@ -97,16 +174,21 @@ private:
     int16_t y;
     int16_t targetX;      // Target position for smooth movement
     int16_t targetY;
-    float openAmount;     // 0.0 = closed, 1.0 = fully open
-    float targetOpen;
+    EyeReal openAmount;   // 0.0 = closed, 1.0 = fully open
+    EyeReal targetOpen;
   // Previous frame values (used to compute minimal redraw region)
   int16_t prevX;
   int16_t prevY;
-  float prevOpenAmount;
+  EyeReal prevOpenAmount;
+  // Shape as last drawn; plain = a rounded rect without lid lines
+  uint8_t prevWidth;
+  uint8_t prevHeight;
+  uint8_t prevRadius;
+  bool prevPlain;
     
     // Mood modifiers
-    float upperLidAngle;  // For mood expressions
-    float lowerLidAngle;
+    EyeReal upperLidAngle;  // For mood expressions
+    EyeReal lowerLidAngle;
   };
   
   Eye _leftEye;
@@ -118,9 +200,11 @@ private:
   Position _currentPosition;
   bool _sweat;
   
-  // Colors
+  // Colors, as drawn in the current pixel format and as set
   uint16_t _colorBg;
   uint16_t _colorMain;
+  uint16_t _colorBgSet;
+  uint16_t _colorMainSet;
   
   // Auto behaviors (moved private variables here)
   uint16_t _blinkInterval;
@@ -136,16 +220,38 @@ private:
   bool _isBlinking;
   unsigned long _blinkStartTime;
   uint16_t _blinkDuration;
+  EyeTimeline<ANIM_PARAM_COUNT> _timeline;
+  
+  // Off-screen canvas for compositing mode (NULL when drawing directly)
+  RoboEyesCanvas *_canvas;
+  EyePixelWriter<Adafruit_ST7789> _pixels;  // canvas pushes in the pixel format
+  
+  // Rounded-rect row extents for eyes that only moved
+  EyeCornerTable _corners;
+  
+  EyeProfiler _profiler;
   
   // Internal methods
+  unsigned long now() const { return _timeSource ? _timeSource() : millis(); }
+  void step();
   void updateEyePositions();
   void updateEyeOpenAmount();
   void updateAutoBehaviors();
   void applyMoodToEye(Eye &eye);
-  void drawSingleEye(Eye &eye);
-  void drawEyeShape(int16_t centerX, int16_t centerY, Eye &eye);
+  void drawDirect(Eye *eyes[], uint8_t eyeCount, int16_t sweatY);
+  bool isPlain(const Eye &eye, uint8_t h) const;
+  void moveEye(const Eye &eye, uint8_t w, uint8_t h, uint8_t r);
+  bool eyeRow(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, int16_t row, int16_t &x0, int16_t &x1) const;
+  void writeOutside(int16_t row, int16_t a0, int16_t a1, int16_t b0, int16_t b1, uint16_t color);
+  void rememberDrawn(Eye &eye);
+  void drawEyeShape(Adafruit_GFX &gfx, int16_t centerX, int16_t centerY, Eye &eye);
+  void drawSweat(Adafruit_GFX &gfx, int16_t sweatX, int16_t sweatY);
+  bool eyeDirtyRect(const Eye &eye, int16_t &x, int16_t &y, int16_t &w, int16_t &h);
+  bool composeFrame(Eye *eyes[], uint8_t eyeCount, int16_t sweatY);
+  bool composeRegion(Eye *eyes[], uint8_t eyeCount, int16_t sweatY,
+                     int16_t x, int16_t y, int16_t w, int16_t h);
   void calculateTargetPosition(Position pos, int16_t &leftX, int16_t &leftY, int16_t &rightX, int16_t &rightY);
-  float easeInOutCubic(float t);
+  EyeReal easeInOutCubic(EyeReal t);
 };
 
 #endif // ROBOEYES_H
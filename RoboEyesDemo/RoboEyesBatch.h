@@ -0,0 +1,213 @@
+/***************************************************
+ * RoboEyesBatch.h - One transaction and few address
+ * windows per frame
+ * Adafruit_GFX opens a transaction for every primitive
+ * and sends CASET, RASET and RAMWR (11 bytes) before
+ * every run of pixels, even where the panel already
+ * holds that window. EyeBatchedPanel<Adafruit_ST7789>
+ * stands in for the display as the eyes' template
+ * parameter: between the eyes' eyeBatchBegin() and
+ * eyeBatchEnd() it keeps one transaction open, leaves
+ * out CASET / RASET the panel already has, and sends
+ * nothing at all for a window that starts where the
+ * last one's pixels stopped (runs along a row, rows
+ * one below the other). Its counters tell what that
+ * saved.
+ ***************************************************/
+
+#ifndef ROBOEYES_BATCH_H
+#define ROBOEYES_BATCH_H
+
+#include <Arduino.h>
+#include <Adafruit_ST77xx.h>
+
+struct EyeBatchStats {
+  uint32_t transactions;       // opened on the bus
+  uint32_t transactionsSaved;  // startWrite()s that found one open
+  uint32_t windows;            // setAddrWindow() calls
+  uint32_t windowsContinued;   // ... that needed no command at all
+  uint32_t commandsSaved;      // CASET, RASET and RAMWR not sent
+  uint32_t bytesSaved;         // their command and data bytes
+};
+
+// Panel: an Adafruit_ST77xx driver. Every window must get exactly the w * h
+// pixels it asked for, as Adafruit_GFX's primitives and EyePixelWriter's
+// RGB565 runs do; with the panel in 12 bpp (COLMOD through sendCommand()
+// here) packed runs may overrun theirs, so windows are then sent as asked.
+// Other commands (invertDisplay(), enableDisplay(), ...) open a transaction
+// of their own: call them between frames, not from inside one.
+template<typename Panel>
+class EyeBatchedPanel : public Panel {
+public:
+  // Same arguments as the panel's constructors
+  template<typename... Args>
+  EyeBatchedPanel(Args... args)
+    : Panel(args...), _depth(0), _framing(false), _held(false), _exact(false) {
+    invalidate();
+    resetBatchStats();
+  }
+
+  // The panel forgets its window on reset
+  template<typename... Args>
+  void init(Args... args) {
+    Panel::init(args...);
+    invalidate();
+  }
+
+  // Around a frame: the first startWrite() opens the transaction, the
+  // endWrite()s in between leave it open, endFrame() closes it
+  void beginFrame() { _framing = true; }
+  void endFrame() {
+    _framing = false;
+    if (!_depth) release();
+  }
+
+  void startWrite(void) override {
+    if (_depth++) return;
+    if (_held) {
+      _batch.transactionsSaved++;
+      return;
+    }
+    Panel::startWrite();
+    _held = true;
+    _batch.transactions++;
+  }
+
+  void endWrite(void) override {
+    if (!_depth || --_depth) return;
+    if (!_framing) release();
+  }
+
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+    _batch.windows++;
+    if (!w || !h) {
+      Panel::setAddrWindow(x, y, w, h);
+      invalidate();
+      return;
+    }
+    x += this->_xstart;
+    y += this->_ystart;
+    uint16_t x1 = x + w - 1, y1 = y + h - 1;
+    if (continues(x, y, x1, y1)) {
+      _batch.windowsContinued++;
+      saved(3, 11);
+    } else {
+      // Open to the right and bottom edges where that can't hurt: the
+      // next window then often continues this one
+      uint16_t right = this->_xstart + this->_width - 1, bottom = this->_ystart + this->_height - 1;
+      uint16_t xEnd = (!_exact && h == 1 && x1 < right) ? right : x1;
+      uint16_t yEnd = (!_exact && y1 < bottom) ? bottom : y1;
+      if (_casKnown && x == _casX0 && xEnd == _casX1) {
+        saved(1, 5);
+      } else {
+        this->writeCommand(ST77XX_CASET);
+        this->SPI_WRITE32((uint32_t)x << 16 | xEnd);
+        _casX0 = x;
+        _casX1 = xEnd;
+        _casKnown = true;
+      }
+      if (_rasKnown && y == _rasY0 && yEnd == _rasY1) {
+        saved(1, 5);
+      } else {
+        this->writeCommand(ST77XX_RASET);
+        this->SPI_WRITE32((uint32_t)y << 16 | yEnd);
+        _rasY0 = y;
+        _rasY1 = yEnd;
+        _rasKnown = true;
+      }
+      this->writeCommand(ST77XX_RAMWR);
+    }
+    advance(x1, y1);
+  }
+
+  void setRotation(uint8_t m) override {
+    bool held = suspend();
+    Panel::setRotation(m);
+    resume(held);
+    invalidate();
+  }
+
+  // Adafruit_SPITFT's, outside the frame's transaction. Any command ends
+  // RAMWR, so the next window needs one again; CASET / RASET stay as they
+  // were. COLMOD tells whether windows may be opened wider than asked.
+  void sendCommand(uint8_t commandByte, const uint8_t *dataBytes = NULL, uint8_t numDataBytes = 0) {
+    bool held = suspend();
+    Panel::sendCommand(commandByte, dataBytes, numDataBytes);
+    resume(held);
+    _atKnown = false;
+    if (commandByte == ST77XX_COLMOD && numDataBytes) _exact = (dataBytes[0] & 0x07) == 0x03;
+  }
+
+  // Whatever the panel holds is no longer known, e.g. after commands sent
+  // around this class
+  void invalidate() { _casKnown = _rasKnown = _atKnown = false; }
+
+  const EyeBatchStats &batchStats() const { return _batch; }
+  void resetBatchStats() { memset(&_batch, 0, sizeof(_batch)); }
+
+private:
+  // The panel's write pointer sits at (x, y) and the window has room for
+  // the run: the rest of a row, or whole rows of it
+  bool continues(uint16_t x, uint16_t y, uint16_t x1, uint16_t y1) const {
+    if (!_atKnown || x != _atX || y != _atY || x1 > _casX1 || y1 > _rasY1) return false;
+    return y1 == y || (x == _casX0 && x1 == _casX1);
+  }
+
+  // Where the pointer goes once the run's pixels are in
+  void advance(uint16_t x1, uint16_t y1) {
+    _atKnown = !_exact;
+    if (x1 < _casX1) {
+      _atX = x1 + 1;
+      _atY = y1;
+    } else {
+      _atX = _casX0;
+      _atY = y1 < _rasY1 ? y1 + 1 : _rasY0;
+    }
+  }
+
+  void saved(uint8_t commands, uint8_t bytes) {
+    _batch.commandsSaved += commands;
+    _batch.bytesSaved += bytes;
+  }
+
+  void release() {
+    if (!_held) return;
+    Panel::endWrite();
+    _held = false;
+  }
+
+  // Close the frame's transaction for a command that opens its own;
+  // reopen it afterwards if a caller is inside startWrite()
+  bool suspend() {
+    bool held = _held;
+    release();
+    return held;
+  }
+  void resume(bool held) {
+    if (!held || !_depth) return;
+    Panel::startWrite();
+    _held = true;
+    _batch.transactions++;
+  }
+
+  uint8_t _depth;  // startWrite()s not yet ended
+  bool _framing;   // between beginFrame() and endFrame()
+  bool _held;      // a transaction is open on the bus
+  bool _exact;     // 12 bpp: windows as asked, pointer not followed
+  bool _casKnown, _rasKnown, _atKnown;
+  uint16_t _casX0, _casX1, _rasY0, _rasY1;  // window the panel holds
+  uint16_t _atX, _atY;                      // its write pointer
+  EyeBatchStats _batch;
+};
+
+// Frame bounds for the eyes' templates; nothing for other displays
+template<typename Display>
+inline void eyeBatchBegin(Display &) {}
+template<typename Display>
+inline void eyeBatchEnd(Display &) {}
+template<typename Panel>
+inline void eyeBatchBegin(EyeBatchedPanel<Panel> &display) { display.beginFrame(); }
+template<typename Panel>
+inline void eyeBatchEnd(EyeBatchedPanel<Panel> &display) { display.endFrame(); }
+
+#endif // ROBOEYES_BATCH_H
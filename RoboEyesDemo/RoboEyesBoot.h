@@ -0,0 +1,203 @@
+/***************************************************
+ * RoboEyesBoot.h - Eyes first at power-up
+ * The panel comes up from a short reset pulse instead
+ * of the driver's 400 ms of reset delays, the eyes get
+ * the look they had before the reset from NVS, and the
+ * first frame is drawn in setup() before anything that
+ * may wait (network, SD, sensors). EyeBootClock marks
+ * each stage so time-to-first-frame can be reported.
+ ***************************************************/
+
+#ifndef ROBOEYES_BOOT_H
+#define ROBOEYES_BOOT_H
+
+#include <Arduino.h>
+#if defined(ESP32)
+#include <Preferences.h>
+#endif
+
+// Stages EyeBootClock keeps
+#ifndef ROBOEYES_BOOT_STAGES
+#define ROBOEYES_BOOT_STAGES 8
+#endif
+
+// How often EyeBootStore::poll() looks for a changed look to save; NVS is
+// written only when something did change, at most this often
+#ifndef ROBOEYES_BOOT_SAVE_MS
+#define ROBOEYES_BOOT_SAVE_MS 10000UL
+#endif
+
+// Hardware reset of the panel: the controller needs a 10 us pulse and 5 ms
+// before it takes commands (ST7789 datasheet), not Adafruit_SPITFT's
+// 100 + 100 + 200 ms. Construct the display with rst = -1 so the driver
+// skips its own, then call this before init().
+inline void eyePanelReset(int8_t rst) {
+  if (rst < 0) return;
+  pinMode(rst, OUTPUT);
+  digitalWrite(rst, LOW);
+  delayMicroseconds(20);
+  digitalWrite(rst, HIGH);
+  delay(5);
+}
+
+// Time of each boot stage, from micros(): time since the app started
+class EyeBootClock {
+public:
+  EyeBootClock() : _count(0), _firstFrameUs(0) {}
+
+  void mark(const char *stage) {
+    if (_count == ROBOEYES_BOOT_STAGES) return;
+    _stage[_count] = stage;
+    _us[_count++] = micros();
+  }
+
+  // The first frame on screen; later calls are ignored
+  void firstFrame() {
+    if (_firstFrameUs) return;
+    _firstFrameUs = max(micros(), 1UL);
+    mark("first frame");
+  }
+
+  // 0 until firstFrame()
+  unsigned long firstFrameMs() const { return _firstFrameUs / 1000; }
+
+  // One line: "boot: panel 182 ms, eyes 214 ms, first frame 236 ms"
+  template<typename Out>
+  void report(Out &out) const {
+    out.print("boot:");
+    for (uint8_t i = 0; i < _count; i++) {
+      out.print(i ? ", " : " ");
+      out.print(_stage[i]);
+      out.print(" ");
+      out.print(_us[i] / 1000);
+      out.print(" ms");
+    }
+    out.println();
+  }
+
+private:
+  const char *_stage[ROBOEYES_BOOT_STAGES];
+  unsigned long _us[ROBOEYES_BOOT_STAGES];
+  uint8_t _count;
+  unsigned long _firstFrameUs;
+};
+
+// The look of the eyes that outlives a reset: shape, mood (0 default,
+// 1 tired, 2 angry, 3 happy, as in FluxGarage_RoboEyes.h) and behaviours
+struct EyeBootConfig {
+  static const uint8_t LAYOUT = 1;  // bump when fields change
+
+  uint8_t layout;
+  uint8_t mood;
+  uint8_t widthL, widthR, heightL, heightR, radiusL, radiusR;
+  int16_t space;
+  bool curious, cyclops;
+  bool autoblinker;
+  int16_t blinkInterval, blinkVariation;
+  bool idle;
+  int16_t idleInterval, idleVariation;
+
+  // From a FluxGarage RoboEyes<>: its defaults, flags and timers' settings
+  template<typename Eyes>
+  void capture(const Eyes &eyes) {
+    memset(this, 0, sizeof(*this));
+    layout = LAYOUT;
+    mood = eyes.tired ? 1 : eyes.angry ? 2 : eyes.happy ? 3 : 0;
+    widthL = eyes.eyeLwidthDefault;
+    widthR = eyes.eyeRwidthDefault;
+    heightL = eyes.eyeLheightDefault;
+    heightR = eyes.eyeRheightDefault;
+    radiusL = eyes.eyeLborderRadiusDefault;
+    radiusR = eyes.eyeRborderRadiusDefault;
+    space = eyes.spaceBetweenDefault;
+    curious = eyes.curious;
+    cyclops = eyes.cyclops;
+    autoblinker = eyes.autoblinker;
+    blinkInterval = eyes.blinkInterval;
+    blinkVariation = eyes.blinkIntervalVariation;
+    idle = eyes.idle;
+    idleInterval = eyes.idleInterval;
+    idleVariation = eyes.idleIntervalVariation;
+  }
+
+  // After eyes.begin(), before the first frame
+  template<typename Eyes>
+  void apply(Eyes &eyes) const {
+    eyes.setWidth(widthL, widthR);
+    eyes.setHeight(heightL, heightR);
+    eyes.setBorderradius(radiusL, radiusR);
+    eyes.setSpacebetween(space);
+    eyes.setMood(mood);
+    eyes.setCuriosity(curious);
+    eyes.setCyclops(cyclops);
+    eyes.setAutoblinker(autoblinker, blinkInterval, blinkVariation);
+    eyes.setIdleMode(idle, idleInterval, idleVariation);
+  }
+
+  bool operator==(const EyeBootConfig &o) const { return !memcmp(this, &o, sizeof(*this)); }
+  bool operator!=(const EyeBootConfig &o) const { return !(*this == o); }
+};
+
+// EyeBootConfig in NVS (ESP32 Preferences); elsewhere nothing is kept
+class EyeBootStore {
+public:
+  EyeBootStore() : _checked(0), _loaded(false) { memset(&_saved, 0, sizeof(_saved)); }
+
+  // The look saved before the reset; false if there is none (first boot,
+  // another layout) and the sketch's own settings stay
+  bool load(EyeBootConfig &config) {
+#if defined(ESP32)
+    Preferences prefs;
+    if (prefs.begin("roboeyes", true)) {
+      _loaded = prefs.getBytes("boot", &_saved, sizeof(_saved)) == sizeof(_saved) &&
+                _saved.layout == EyeBootConfig::LAYOUT;
+      prefs.end();
+    }
+#endif
+    if (_loaded) config = _saved;
+    return _loaded;
+  }
+
+  // From loop(), where it may read the eyes (nothing else draws them):
+  // saves their look when it changed since the last save
+  template<typename Eyes>
+  void poll(const Eyes &eyes, unsigned long now) {
+    if (!due(now)) return;
+    EyeBootConfig current;
+    current.capture(eyes);
+    offer(current);
+  }
+
+  // With the eyes on a render task of their own: true once every
+  // ROBOEYES_BOOT_SAVE_MS, time to have that task capture() the look and
+  // hand it to offer()
+  bool due(unsigned long now) {
+    if (now - _checked < ROBOEYES_BOOT_SAVE_MS) return false;
+    _checked = now;
+    return true;
+  }
+
+  // Saves a captured look if it differs from the saved one
+  void offer(const EyeBootConfig &current) {
+    if (_loaded && current == _saved) return;
+    save(current);
+  }
+
+private:
+  void save(const EyeBootConfig &config) {
+    _saved = config;
+    _loaded = true;
+#if defined(ESP32)
+    Preferences prefs;
+    if (!prefs.begin("roboeyes", false)) return;
+    prefs.putBytes("boot", &config, sizeof(config));
+    prefs.end();
+#endif
+  }
+
+  EyeBootConfig _saved;
+  unsigned long _checked;
+  bool _loaded;  // _saved matches NVS
+};
+
+#endif // ROBOEYES_BOOT_H
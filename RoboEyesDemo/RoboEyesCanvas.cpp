@@ -0,0 +1,129 @@
+/***************************************************
+ * RoboEyesCanvas.cpp - Implementation
+ ***************************************************/
+
+#include "RoboEyesCanvas.h"
+#if defined(ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+RoboEyesCanvas::RoboEyesCanvas(int16_t w, int16_t h, bool indexed)
+  : Adafruit_GFX(w, h),
+    _buffer(NULL),
+    _capacity(0),
+    _vx(0), _vy(0), _vw(0), _vh(0),
+    _indexed(indexed),
+    _stride(0)
+{
+  _palette[0] = 0x0000;
+  _palette[1] = 0xFFFF;
+}
+
+RoboEyesCanvas::~RoboEyesCanvas() {
+  free(_buffer);
+}
+
+bool RoboEyesCanvas::reserve(uint32_t maxPixels, bool dmaCapable) {
+  free(_buffer);
+  _buffer = NULL;
+  _capacity = 0;
+
+  // Don't bother below one small eye box; direct drawing is better then
+  while (maxPixels >= 1024) {
+    size_t bytes = _indexed ? (maxPixels + 7) / 8 : maxPixels * sizeof(uint16_t);
+#if defined(ESP32)
+    // The SPI DMA engine can't read PSRAM
+    if (dmaCapable) _buffer = (uint16_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+    else if (psramFound()) _buffer = (uint16_t *)ps_malloc(bytes);
+#else
+    (void)dmaCapable;
+#endif
+    if (!_buffer) _buffer = (uint16_t *)malloc(bytes);
+    if (_buffer) {
+      _capacity = maxPixels;
+      return true;
+    }
+    maxPixels /= 2;
+  }
+  return false;
+}
+
+bool RoboEyesCanvas::fits(int16_t w, int16_t h) const {
+  // Indexed rows start on a byte
+  if (_indexed) w = (w + 7) & ~7;
+  return (uint32_t)w * h <= _capacity;
+}
+
+bool RoboEyesCanvas::setViewport(int16_t x, int16_t y, int16_t w, int16_t h) {
+  if (w <= 0 || h <= 0 || !fits(w, h)) return false;
+  _vx = x;
+  _vy = y;
+  _vw = w;
+  _vh = h;
+  _stride = (w + 7) / 8;
+  return true;
+}
+
+void RoboEyesCanvas::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  x -= _vx;
+  y -= _vy;
+  if (x < 0 || y < 0 || x >= _vw || y >= _vh) return;
+  if (_indexed) fillBits((uint8_t *)_buffer + (int32_t)y * _stride, x, x + 1, color == _palette[1]);
+  else _buffer[(int32_t)y * _vw + x] = color;
+}
+
+void RoboEyesCanvas::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  fillRect(x, y, w, 1, color);
+}
+
+void RoboEyesCanvas::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  fillRect(x, y, 1, h, color);
+}
+
+void RoboEyesCanvas::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  // Same negative-size convention as Adafruit_SPITFT
+  if (w < 0) { x += w + 1; w = -w; }
+  if (h < 0) { y += h + 1; h = -h; }
+
+  // To viewport space and clip
+  int16_t x1 = x - _vx;
+  int16_t y1 = y - _vy;
+  int16_t x2 = x1 + w;
+  int16_t y2 = y1 + h;
+  if (x1 < 0) x1 = 0;
+  if (y1 < 0) y1 = 0;
+  if (x2 > _vw) x2 = _vw;
+  if (y2 > _vh) y2 = _vh;
+  if (x1 >= x2 || y1 >= y2) return;
+
+  if (_indexed) {
+    for (int16_t row = y1; row < y2; row++) {
+      fillBits((uint8_t *)_buffer + (int32_t)row * _stride, x1, x2, color == _palette[1]);
+    }
+    return;
+  }
+  for (int16_t row = y1; row < y2; row++) {
+    uint16_t *p = _buffer + (int32_t)row * _vw + x1;
+    for (int16_t i = x1; i < x2; i++) *p++ = color;
+  }
+}
+
+void RoboEyesCanvas::fillScreen(uint16_t color) {
+  if (_indexed) {
+    memset(_buffer, color == _palette[1] ? 0xFF : 0x00, (size_t)_stride * _vh);
+    return;
+  }
+  uint32_t n = (uint32_t)_vw * _vh;
+  for (uint32_t i = 0; i < n; i++) _buffer[i] = color;
+}
+
+// Bits x1..x2-1 of an indexed row (MSB = leftmost pixel), whole bytes at once
+void RoboEyesCanvas::fillBits(uint8_t *row, int16_t x1, int16_t x2, bool set) {
+  int16_t b1 = x1 >> 3, b2 = (x2 - 1) >> 3;
+  uint8_t head = 0xFF >> (x1 & 7), tail = 0xFF << (7 - ((x2 - 1) & 7));
+  if (b1 == b2) head &= tail;
+  row[b1] = set ? (row[b1] | head) : (row[b1] & ~head);
+  if (b1 == b2) return;
+  if (b2 > b1 + 1) memset(row + b1 + 1, set ? 0xFF : 0x00, b2 - b1 - 1);
+  row[b2] = set ? (row[b2] | tail) : (row[b2] & ~tail);
+}
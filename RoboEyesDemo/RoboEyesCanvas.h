@@ -0,0 +1,99 @@
+/***************************************************
+ * RoboEyesCanvas.h - Off-screen RGB565 canvas
+ * An Adafruit_GFX target backed by RAM. Only a movable
+ * viewport (usually the dirty box of one frame) is
+ * stored; everything outside it is clipped. The result
+ * goes to the panel as a single address window.
+ * Indexed canvases keep one bit per pixel against a
+ * two-colour palette (9.6 KB for all of 320x240) and
+ * expand it to RGB565 a few pixels at a time on flush.
+ ***************************************************/
+
+#ifndef ROBOEYES_CANVAS_H
+#define ROBOEYES_CANVAS_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// Pixels an indexed canvas expands per push on flush (stack line buffer)
+#ifndef ROBOEYES_CANVAS_EXPAND
+#define ROBOEYES_CANVAS_EXPAND 64
+#endif
+
+class RoboEyesCanvas : public Adafruit_GFX {
+public:
+  // w/h are the logical screen size (what the eyes code draws in).
+  // indexed: 1 bit per pixel, see setPalette()
+  RoboEyesCanvas(int16_t w, int16_t h, bool indexed = false);
+  ~RoboEyesCanvas();
+
+  // Allocate backing store for up to maxPixels (PSRAM preferred when present,
+  // internal DMA-capable RAM if dmaCapable). Halves the request until it
+  // fits; returns false if nothing could be had.
+  bool reserve(uint32_t maxPixels, bool dmaCapable = false);
+  uint32_t capacity() const { return _capacity; }
+  bool indexed() const { return _indexed; }
+  // True if a w x h viewport fits the backing store
+  bool fits(int16_t w, int16_t h) const;
+
+  // Indexed canvas: drawing in main sets a pixel, any other colour clears it
+  // to background. Set before drawing the frame.
+  void setPalette(uint16_t background, uint16_t main) {
+    _palette[0] = background;
+    _palette[1] = main;
+  }
+
+  // Select the screen area the next frame renders into. Returns false if the
+  // area does not fit the backing store (caller should draw directly instead).
+  bool setViewport(int16_t x, int16_t y, int16_t w, int16_t h);
+
+  int16_t viewportX() const { return _vx; }
+  int16_t viewportY() const { return _vy; }
+  int16_t viewportW() const { return _vw; }
+  int16_t viewportH() const { return _vh; }
+  uint16_t *getBuffer() const { return _indexed ? NULL : _buffer; }  // RGB565 only
+
+  // Adafruit_GFX target
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void fillScreen(uint16_t color) override; // fills the viewport only
+
+  // Push the viewport to the panel: one setAddrWindow + bulk pixel write.
+  // An indexed canvas needs an EyePixelWriter (RoboEyesPixels.h) as target,
+  // fed one line buffer of expanded pixels at a time.
+  template<typename Display>
+  void flush(Display &display) {
+    if (_vw <= 0 || _vh <= 0) return;
+    if (!_indexed) {
+      display.drawRGBBitmap(_vx, _vy, _buffer, _vw, _vh);
+      return;
+    }
+    uint16_t line[ROBOEYES_CANVAS_EXPAND];
+    display.open(_vx, _vy, _vw, _vh);
+    for (int16_t row = 0; row < _vh; row++) {
+      const uint8_t *bits = (const uint8_t *)_buffer + (int32_t)row * _stride;
+      for (int16_t x = 0; x < _vw; x += ROBOEYES_CANVAS_EXPAND) {
+        int16_t n = min((int16_t)(_vw - x), (int16_t)ROBOEYES_CANVAS_EXPAND);
+        for (int16_t i = 0; i < n; i++) {
+          line[i] = _palette[(bits[(x + i) >> 3] >> (7 - ((x + i) & 7))) & 1];
+        }
+        display.push(line, n);
+      }
+    }
+    display.close();
+  }
+
+private:
+  void fillBits(uint8_t *row, int16_t x1, int16_t x2, bool set);
+
+  uint16_t *_buffer;
+  uint32_t _capacity;   // pixels
+  int16_t _vx, _vy, _vw, _vh;
+  bool _indexed;
+  uint16_t _stride;     // indexed: bytes per viewport row
+  uint16_t _palette[2];
+};
+
+#endif // ROBOEYES_CANVAS_H
@@ -0,0 +1,89 @@
+/***************************************************
+ * RoboEyesCorners.h - Quarter-circle corner tables
+ * For every corner radius up to a limit, the columns
+ * Adafruit_GFX::fillCircleHelper() leaves out on each
+ * side of a rounded rect, row by row from the top or
+ * bottom edge. Built once, so drawing a corner row is
+ * a table lookup instead of a circle walk.
+ ***************************************************/
+
+#ifndef ROBOEYES_CORNERS_H
+#define ROBOEYES_CORNERS_H
+
+#include <Arduino.h>
+
+class EyeCornerTable {
+public:
+  EyeCornerTable() : _insets(NULL), _maxRadius(0) {}
+  ~EyeCornerTable() { free(_insets); }
+
+  // Tables for radii 1..maxRadius (maxRadius * (maxRadius + 1) / 2 bytes),
+  // replacing any built before; false if the memory can't be had (lookups
+  // then walk the circle)
+  bool begin(uint8_t maxRadius) {
+    if (maxRadius == _maxRadius && _insets) return true;
+    free(_insets);
+    _insets = NULL;
+    _maxRadius = 0;
+    if (!maxRadius) return true;
+    _insets = (uint8_t *)malloc((uint16_t)maxRadius * (maxRadius + 1) / 2);
+    if (!_insets) return false;
+    _maxRadius = maxRadius;
+    for (uint8_t r = 1; r <= maxRadius; r++) build(r, _insets + offset(r));
+    return true;
+  }
+
+  // Inset of a radius-r corner, d rows away from the top or bottom edge;
+  // radii past 255 are drawn as 255
+  int16_t inset(int16_t r, int16_t d) const {
+    if (r > 255) r = 255;
+    if (d >= r || r <= 0) return 0;
+    if (r <= _maxRadius) return _insets[offset(r) + d];
+    uint8_t row[255];
+    build(r, row);
+    return row[d];
+  }
+
+  uint8_t maxRadius() const { return _maxRadius; }
+
+  // Insets of a radius-r corner for d = 0..r-1 into out, in one circle walk
+  static void build(uint8_t r, uint8_t *out) {
+    // reach[d]: widest column offset whose vertical line starts by row d
+    memset(out, 0, r);
+    int16_t f = 1 - r, ddF_x = 1, ddF_y = -2 * r;
+    int16_t x = 0, y = r, px = x, py = y;
+    while (x < y) {
+      if (f >= 0) {
+        y--;
+        ddF_y += 2;
+        f += ddF_y;
+      }
+      x++;
+      ddF_x += 2;
+      f += ddF_x;
+      if (x < (y + 1)) reachAt(out, r, r - y, x);
+      if (y != py) {
+        reachAt(out, r, r - px, py);
+        py = y;
+      }
+      px = x;
+    }
+    uint8_t reach = 0;
+    for (uint8_t d = 0; d < r; d++) {
+      if (out[d] > reach) reach = out[d];
+      out[d] = r - reach;
+    }
+  }
+
+private:
+  static uint16_t offset(uint8_t r) { return (uint16_t)r * (r - 1) / 2; }
+
+  static void reachAt(uint8_t *reach, uint8_t r, int16_t d, int16_t col) {
+    if (d < r && col > reach[d]) reach[d] = col;
+  }
+
+  uint8_t *_insets;
+  uint8_t _maxRadius;
+};
+
+#endif // ROBOEYES_CORNERS_H
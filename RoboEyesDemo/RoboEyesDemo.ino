@@ -6,8 +6,15 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
 #include <SPI.h>
+#include "RoboEyesTask.h"  // before the eyes: they define short macros (N, E, S, ...)
+#include "RoboEyesBoot.h"
+#include "RoboEyesBatch.h"
 #include "FluxGarage_RoboEyes.h"
 
+// Uncomment to draw the eyes from a task pinned to core 0 (ESP32 only);
+// loop() then only reads Serial and posts commands
+// #define ROBOEYES_THREADED
+
 // ST7789 Pin definitions
 #define TFT_CS    5
 #define TFT_DC    16
@@ -15,20 +22,46 @@
 #define TFT_SDA   23  // MOSI
 #define TFT_SCK   18  // SCK
 
-// Create display object
-Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
+// Create display object; no reset pin here, setup() pulses TFT_RST itself
+// (eyePanelReset) instead of the driver's 400 ms of reset delays. Batched:
+// one SPI transaction per eye frame and no repeated address windows
+typedef EyeBatchedPanel<Adafruit_ST7789> EyePanel;
+EyePanel tft(TFT_CS, TFT_DC, -1);
 
 // Create RoboEyes object (FluxGarage port for ST7789)
-RoboEyes<Adafruit_ST7789> eyes(tft);
+RoboEyes<EyePanel> eyes(tft);
+
+// Commands reach the eyes through this queue, threaded or not
+RoboEyesTask<RoboEyes<EyePanel> > eyesTask(eyes);
+
+// 'w' turns sweat off again here instead of blocking in delay()
+unsigned long sweatOffTime = 0;
+
+// Time to the first frame, and the look kept across resets
+EyeBootClock bootClock;
+EyeBootStore bootStore;
+
+// Threaded, only the render task may read the eyes: it captures their look
+// on this command and hands it back to loop() for saving
+const uint8_t EYE_CMD_BOOT_LOOK = EYE_CMD_USER;
+EyeHandoff<EyeBootConfig> bootLook;
+
+void onEyesCommand(RoboEyes<EyePanel> &e, const EyeCommand &cmd) {
+  if (cmd.type != EYE_CMD_BOOT_LOOK) return;
+  bootLook.back().capture(e);
+  bootLook.publish();
+}
 
 void setup() {
+  bootClock.mark("setup");
   Serial.begin(115200);
   Serial.println("\n🤖 RoboEyes ST7789 Demo");
   
-  // Initialize display
+  // Initialize display (eyes.begin() clears it)
+  eyePanelReset(TFT_RST);
   tft.init(240, 320);
   tft.setRotation(2); // Portrait mode (240x320) - vertical
-  tft.fillScreen(ST77XX_BLACK);
+  bootClock.mark("panel");
   
   // Initialize RoboEyes (width,height,maxFPS)
   // Note: for rotation=0 the logical width/height are 240x320
@@ -47,14 +80,45 @@ void setup() {
   // Use slower defaults: auto-blink ~12s ±3s and idle every 12s (no variation)
   eyes.setAutoblinker(ON, 12, 3); // active, interval (s), variation (s)
   eyes.setIdleMode(ON, 12, 0); // idle every 12s exactly
+
+  // The look from before the last reset, if one was saved
+  EyeBootConfig look;
+  if (bootStore.load(look)) look.apply(eyes);
+  bootClock.mark("eyes");
+
+  // First frame now, before anything that may wait; update() would hold
+  // it back until a whole frame interval after power-up
+  eyes.drawEyes();
+  bootClock.firstFrame();
+  
+#ifdef ROBOEYES_THREADED
+  // From here on only the render task touches eyes and tft
+  eyesTask.setCommandHook(onEyesCommand);
+  if (eyesTask.begin()) Serial.println("🧵 Rendering on core " + String(ROBOEYES_RENDER_CORE));
+#endif
   
   Serial.println("✅ Initialized!");
+  bootClock.report(Serial);
   printHelp();
 }
 
 void loop() {
-  // Update eyes (handles auto blink and idle)
-  eyes.update();
+  // Apply queued commands and update eyes (handles auto blink and idle);
+  // the render task does this itself when threaded
+  if (!eyesTask.running()) eyesTask.poll();
+
+  // Save the look when it changed (at most every ROBOEYES_BOOT_SAVE_MS)
+  if (!eyesTask.running()) {
+    bootStore.poll(eyes, millis());
+  } else {
+    if (bootStore.due(millis())) eyesTask.post(EYE_CMD_BOOT_LOOK);
+    if (bootLook.acquire()) bootStore.offer(bootLook.front());
+  }
+  
+  if (sweatOffTime && (long)(millis() - sweatOffTime) >= 0) {
+    eyesTask.post(EYE_CMD_SWEAT, false);
+    sweatOffTime = 0;
+  }
   
   // Check serial commands
   if (Serial.available()) {
@@ -68,139 +132,165 @@ void handleCommand(char cmd) {
     // === MOODS ===
     // Use letter commands for moods to avoid colliding with numeric position keys
     case 'h':
-      eyes.setMood(HAPPY);
+      eyesTask.post(EYE_CMD_MOOD, HAPPY);
       Serial.println("😊 HAPPY - Vui vẻ");
       break;
 
     case 's':
-      eyes.setMood(DEFAULT); // FluxGarage has no SAD constant separate from DEFAULT; use DEFAULT or implement if needed
+      eyesTask.post(EYE_CMD_MOOD, DEFAULT); // FluxGarage has no SAD constant separate from DEFAULT; use DEFAULT or implement if needed
       Serial.println("😢 SAD - Buồn");
       break;
 
     case 'a':
-      eyes.setMood(ANGRY);
+      eyesTask.post(EYE_CMD_MOOD, ANGRY);
       Serial.println("😠 ANGRY - Giận dữ");
       break;
 
     case 't':
-      eyes.setMood(TIRED);
+      eyesTask.post(EYE_CMD_MOOD, TIRED);
       Serial.println("😴 TIRED - Mệt mỏi");
       break;
 
     case 'n':
-      eyes.setMood(DEFAULT);
+      eyesTask.post(EYE_CMD_MOOD, DEFAULT);
       Serial.println("😐 DEFAULT - Bình thường");
       break;
     
     // === POSITIONS ===
     case '8':
-      eyes.setPosition(N);
+      eyesTask.post(EYE_CMD_POSITION, N);
       Serial.println("⬆️ NORTH - Nhìn lên");
       break;
       
     case '9':
-      eyes.setPosition(NE);
+      eyesTask.post(EYE_CMD_POSITION, NE);
       Serial.println("↗️ NORTH-EAST");
       break;
       
     case '6':
-      eyes.setPosition(E);
+      eyesTask.post(EYE_CMD_POSITION, E);
       Serial.println("➡️ EAST - Nhìn phải");
       break;
       
     case '3':
-      eyes.setPosition(SE);
+      eyesTask.post(EYE_CMD_POSITION, SE);
       Serial.println("↘️ SOUTH-EAST");
       break;
       
     case '2':
-      eyes.setPosition(S);
+      eyesTask.post(EYE_CMD_POSITION, S);
       Serial.println("⬇️ SOUTH - Nhìn xuống");
       break;
       
     case '1':
-      eyes.setPosition(SW);
+      eyesTask.post(EYE_CMD_POSITION, SW);
       Serial.println("↙️ SOUTH-WEST");
       break;
       
     case '4':
-      eyes.setPosition(W);
+      eyesTask.post(EYE_CMD_POSITION, W);
       Serial.println("⬅️ WEST - Nhìn trái");
       break;
       
     case '7':
-      eyes.setPosition(NW);
+      eyesTask.post(EYE_CMD_POSITION, NW);
       Serial.println("↖️ NORTH-WEST");
       break;
       
     case '5':
     case 'c':
-      eyes.setPosition(DEFAULT);
+      eyesTask.post(EYE_CMD_POSITION, DEFAULT);
       Serial.println("⏺️ CENTER - Giữa");
       break;
     
     // === ACTIONS ===
     case 'b':
-      eyes.blink();
+      eyesTask.post(EYE_CMD_BLINK, true, true);
       Serial.println("👁️ BLINK - Nháy mắt");
       break;
       
     case 'o':
-      eyes.open();
+      eyesTask.post(EYE_CMD_OPEN, true, true);
       Serial.println("👀 OPEN - Mở mắt");
       break;
       
     case 'x':
-      eyes.close();
+      eyesTask.post(EYE_CMD_CLOSE, true, true);
       Serial.println("😑 CLOSE - Nhắm mắt");
       break;
     
     // === ANIMATIONS ===
     case 'l':
       Serial.println("😂 LAUGH - Cười");
-      eyes.anim_laugh();
+      eyesTask.post(EYE_CMD_LAUGH);
       break;
       
     case 'f':
       Serial.println("😕 CONFUSED - Bối rối");
-      eyes.anim_confused();
+      eyesTask.post(EYE_CMD_CONFUSED);
       break;
     
     // === FEATURES ===
     case 'w':
-      eyes.setSweat(true);
+      eyesTask.post(EYE_CMD_SWEAT, true);
       Serial.println("💦 SWEAT ON - Bật mồ hôi");
-      delay(2000);
-      eyes.setSweat(false);
+      sweatOffTime = millis() + 2000;
       break;
       
-    case 'u':
-      eyes.setCuriosity(!eyes.curious);
+    // Toggles read the current state here, the render task applies the new one
+    case 'u': {
+      bool curious = !eyes.curious;
+      eyesTask.post(EYE_CMD_CURIOSITY, curious);
       Serial.print("👁️ CURIOSITY: ");
-      Serial.println(eyes.curious ? "ON" : "OFF");
+      Serial.println(curious ? "ON" : "OFF");
       break;
+    }
       
-    case 'y':
-      eyes.setCyclops(!eyes.cyclops);
+    case 'y': {
+      bool cyclops = !eyes.cyclops;
+      eyesTask.post(EYE_CMD_CYCLOPS, cyclops);
       Serial.print("👁️ CYCLOPS: ");
-      Serial.println(eyes.cyclops ? "ON" : "OFF");
+      Serial.println(cyclops ? "ON" : "OFF");
       break;
+    }
     
     // === AUTO MODES ===
-    case 'A':
+    case 'A': {
       // Keep the same slower defaults when toggling from serial (FluxGarage API)
-  eyes.setAutoblinker(!eyes.autoblinker, 12, 3);
+      bool autoblinker = !eyes.autoblinker;
+      eyesTask.post(EYE_CMD_AUTOBLINKER, autoblinker, 12, 3);
       Serial.print("🔄 AUTO BLINK: ");
-      Serial.println(eyes.autoblinker ? "ON" : "OFF");
+      Serial.println(autoblinker ? "ON" : "OFF");
       break;
+    }
       
-    case 'I':
+    case 'I': {
       // Toggle idle mode and keep the default interval at 5s with no variation
-  eyes.setIdleMode(!eyes.idle, 12, 0);
+      bool idle = !eyes.idle;
+      eyesTask.post(EYE_CMD_IDLE, idle, 12, 0);
       Serial.print("🔄 IDLE MODE: ");
-      Serial.println(eyes.idle ? "ON" : "OFF");
+      Serial.println(idle ? "ON" : "OFF");
       break;
+    }
     
+    // === PROFILER (build with ROBOEYES_PROFILE) ===
+    // Printed by whoever draws, between frames, so the counters are consistent
+    case 'p':
+    case 'P':
+      Serial.println(cmd == 'P' ? "📊 FRAME PROFILE (then reset)" : "📊 FRAME PROFILE");
+      eyesTask.post(EYE_CMD_STATS, cmd == 'P');
+      break;
+
+    // What the batched panel kept off the bus since power-up
+    case 'q': {
+      const EyeBatchStats &st = tft.batchStats();
+      Serial.println("🚌 SPI: " + String(st.transactions) + " transactions (" + String(st.transactionsSaved) +
+                     " saved), " + String(st.windows) + " windows (" + String(st.windowsContinued) +
+                     " continued), " + String(st.commandsSaved) + " commands / " + String(st.bytesSaved) +
+                     " bytes saved");
+      break;
+    }
+
     // === HELP ===
     case '?':
       printHelp();
@@ -250,6 +340,10 @@ void printHelp() {
   Serial.println("║  A = 🔄 Toggle Auto Blink              ║");
   Serial.println("║  I = 🔄 Toggle Idle Mode               ║");
   Serial.println("╠════════════════════════════════════════╣");
+  Serial.println("║ PROFILER:                              ║");
+  Serial.println("║  p = 📊 Frame profile (P = and reset)  ║");
+  Serial.println("║  q = 🚌 SPI batching counters          ║");
+  Serial.println("╠════════════════════════════════════════╣");
   Serial.println("║  ? = Show this help                    ║");
   Serial.println("╚════════════════════════════════════════╝\n");
 }
@@ -0,0 +1,153 @@
+/***************************************************
+ * RoboEyesDirty.h - Dirty-region tracking for RoboEyes
+ * Each drawable part of the face (eye, eyelids, sweat
+ * drop) owns a slot. Per frame a slot reports the box it
+ * covers plus a signature of what it drew; slots whose
+ * box or signature changed contribute their old and new
+ * boxes, and overlapping boxes are merged.
+ ***************************************************/
+
+#ifndef ROBOEYES_DIRTY_H
+#define ROBOEYES_DIRTY_H
+
+#include <Arduino.h>
+
+struct DirtyRect {
+  int16_t x, y, w, h;
+
+  bool empty() const { return w <= 0 || h <= 0; }
+  uint32_t area() const { return empty() ? 0 : (uint32_t)w * h; }
+  bool operator==(const DirtyRect &o) const { return x == o.x && y == o.y && w == o.w && h == o.h; }
+  bool operator!=(const DirtyRect &o) const { return !(*this == o); }
+
+  bool intersects(const DirtyRect &o) const {
+    return !empty() && !o.empty() &&
+           x < o.x + o.w && o.x < x + w && y < o.y + o.h && o.y < y + h;
+  }
+
+  // Grow to cover o as well
+  void unite(const DirtyRect &o) {
+    if (o.empty()) return;
+    if (empty()) { *this = o; return; }
+    int16_t x2 = max(x + w, o.x + o.w);
+    int16_t y2 = max(y + h, o.y + o.h);
+    x = min(x, o.x);
+    y = min(y, o.y);
+    w = x2 - x;
+    h = y2 - y;
+  }
+
+  void clip(int16_t screenW, int16_t screenH) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > screenW) w = screenW - x;
+    if (y + h > screenH) h = screenH - y;
+    if (w < 0) w = 0;
+    if (h < 0) h = 0;
+  }
+};
+
+// Small fixed list of screen rectangles that need repainting this frame
+class DirtyRegions {
+public:
+  static const uint8_t MAX_RECTS = 12;
+
+  DirtyRegions() : _count(0) {}
+
+  void clear() { _count = 0; }
+  uint8_t count() const { return _count; }
+  const DirtyRect &operator[](uint8_t i) const { return _rects[i]; }
+
+  uint32_t area() const {
+    uint32_t a = 0;
+    for (uint8_t i = 0; i < _count; i++) a += _rects[i].area();
+    return a;
+  }
+
+  // Add a rectangle, merging it with any overlapping one when the merged box
+  // costs no more pixels than keeping both
+  void add(DirtyRect r) {
+    if (r.empty()) return;
+    bool merged = true;
+    while (merged) {
+      merged = false;
+      for (uint8_t i = 0; i < _count; i++) {
+        if (!_rects[i].intersects(r)) continue;
+        DirtyRect u = r;
+        u.unite(_rects[i]);
+        if (u.area() > r.area() + _rects[i].area()) continue;
+        r = u;
+        _rects[i] = _rects[--_count];
+        merged = true;
+        break;
+      }
+    }
+
+    if (_count < MAX_RECTS) {
+      _rects[_count++] = r;
+      return;
+    }
+
+    // Full: fold into the rectangle that grows the least
+    uint8_t best = 0;
+    uint32_t bestGrowth = 0xFFFFFFFFUL;
+    for (uint8_t i = 0; i < _count; i++) {
+      DirtyRect u = _rects[i];
+      u.unite(r);
+      uint32_t growth = u.area() - _rects[i].area();
+      if (growth < bestGrowth) { bestGrowth = growth; best = i; }
+    }
+    _rects[best].unite(r);
+  }
+
+private:
+  DirtyRect _rects[MAX_RECTS];
+  uint8_t _count;
+};
+
+// Per-slot footprint and content signature, diffed against the previous frame
+template<uint8_t SLOTS>
+class DirtyTracker {
+public:
+  DirtyTracker() { invalidate(); }
+
+  // Forget the previous frame so every slot is repainted next time
+  void invalidate() {
+    for (uint8_t i = 0; i < SLOTS; i++) {
+      _prev[i].x = _prev[i].y = _prev[i].w = _prev[i].h = 0;
+      _prevSig[i] = 0;
+    }
+    _forced = true;
+  }
+
+  // slot: current box (already clipped to the screen) and content signature.
+  // Adds the areas that changed to out and remembers this frame.
+  void update(uint8_t slot, const DirtyRect &box, uint32_t signature, DirtyRegions &out) {
+    if (_forced || box != _prev[slot] || signature != _prevSig[slot]) {
+      DirtyRect u = _prev[slot];
+      u.unite(box);
+      if (u.area() <= _prev[slot].area() + box.area()) {
+        out.add(u);
+      } else {
+        out.add(_prev[slot]);
+        out.add(box);
+      }
+    }
+    _prev[slot] = box;
+    _prevSig[slot] = signature;
+  }
+
+  // Call once all slots of a frame went through update()
+  void commit() { _forced = false; }
+
+  // True until the first commit() after invalidate(): the panel may then
+  // hold anything, not the previous frame
+  bool forced() const { return _forced; }
+
+private:
+  DirtyRect _prev[SLOTS];
+  uint32_t _prevSig[SLOTS];
+  bool _forced;
+};
+
+#endif // ROBOEYES_DIRTY_H
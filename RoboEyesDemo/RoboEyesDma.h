@@ -0,0 +1,171 @@
+/***************************************************
+ * RoboEyesDma.h - Asynchronous pixel transfer backends
+ * A backend pushes one window of RGB565 pixels to the
+ * panel without blocking and reports completion through
+ * a callback, so rendering can overlap the transfer.
+ ***************************************************/
+
+#ifndef ROBOEYES_DMA_H
+#define ROBOEYES_DMA_H
+
+#include <Arduino.h>
+#if defined(ESP32)
+#include <driver/spi_master.h>
+#endif
+
+class RoboEyesDma {
+public:
+  typedef void (*DoneCallback)(void *ctx);
+
+  RoboEyesDma() : _done(NULL), _doneCtx(NULL) {}
+  virtual ~RoboEyesDma() {}
+
+  // Called once per finished transfer (from poll()/busy()/wait() or an ISR)
+  void onDone(DoneCallback cb, void *ctx) { _done = cb; _doneCtx = ctx; }
+
+  // Start sending w*h pixels (native byte order) into the window. Only called
+  // while !busy(). The backend may reorder the bytes in place; pixels belong
+  // to it until the done callback ran.
+  virtual void start(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *pixels) = 0;
+  virtual bool busy() = 0;
+
+  // Backends without a completion interrupt notice the end of a transfer here
+  virtual void poll() { busy(); }
+
+  // Block until the current transfer is done
+  virtual void wait() { while (busy()) yield(); }
+
+protected:
+  void finished() { if (_done) _done(_doneCtx); }
+
+private:
+  DoneCallback _done;
+  void *_doneCtx;
+};
+
+// Adafruit_SPITFT's non-blocking writePixels(): real DMA where the library
+// enables it (USE_SPI_DMA: SAMD51, RP2040), a plain blocking write everywhere
+// else, ESP32 included (use RoboEyesEsp32Dma there)
+template<typename Display>
+class RoboEyesSpiTftDma : public RoboEyesDma {
+public:
+  explicit RoboEyesSpiTftDma(Display &display) : _display(display), _active(false) {}
+
+  void start(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *pixels) override {
+    _display.startWrite();
+    _display.setAddrWindow(x, y, w, h);
+    _display.writePixels(pixels, (uint32_t)w * h, false);
+    _active = true;
+  }
+
+  bool busy() override {
+    if (_active && !_display.dmaBusy()) {
+      _display.endWrite();
+      _active = false;
+      finished();
+    }
+    return _active;
+  }
+
+  void wait() override {
+    if (!_active) return;
+    _display.dmaWait();
+    busy();
+  }
+
+private:
+  Display &_display;
+  bool _active;
+};
+
+#if defined(ESP32)
+// esp-idf's spi_master queues the pixels on the host's DMA channel and
+// returns at once. The display keeps driving the same SPI host through the
+// Arduino SPI driver for everything else: start() opens the window through
+// it (CS stays low, DC high after RAMWR) and only the pixel data goes out
+// through spi_master, on a device without a CS pin of its own. Pass the
+// host and pins the display uses (VSPI_HOST, 23, 18 for the default SPI of
+// a classic ESP32; SPI2_HOST on the S3/C3) and its SPI clock and mode.
+// Completion is polled, so pump() must run for the next strip to start.
+// Follows how TFT_eSPI drives DMA next to Arduino SPI; not yet run on a panel.
+template<typename Display>
+class RoboEyesEsp32Dma : public RoboEyesDma {
+public:
+  RoboEyesEsp32Dma(Display &display, spi_host_device_t host, int8_t mosi, int8_t sclk,
+                   uint32_t hz = 40000000UL, uint8_t mode = 0)
+    : _display(display), _host(host), _mosi(mosi), _sclk(sclk), _hz(hz), _mode(mode),
+      _dev(NULL), _active(false) {}
+
+  ~RoboEyesEsp32Dma() {
+    wait();
+    if (_dev) spi_bus_remove_device(_dev);
+  }
+
+  // Call after display.init(); maxPixels is the largest window sent at once
+  // (the strip size). False if the bus or the device can't be had.
+  bool begin(uint32_t maxPixels) {
+    spi_bus_config_t bus;
+    memset(&bus, 0, sizeof(bus));
+    bus.mosi_io_num = _mosi;
+    bus.miso_io_num = -1;
+    bus.sclk_io_num = _sclk;
+    bus.quadwp_io_num = -1;
+    bus.quadhd_io_num = -1;
+    bus.max_transfer_sz = maxPixels * 2;
+    bus.flags = SPICOMMON_BUSFLAG_MASTER;
+    esp_err_t err = spi_bus_initialize(_host, &bus, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return false;  // INVALID_STATE: already up
+
+    spi_device_interface_config_t dev;
+    memset(&dev, 0, sizeof(dev));
+    dev.mode = _mode;
+    dev.clock_speed_hz = _hz;
+    dev.spics_io_num = -1;
+    dev.queue_size = 1;
+    dev.flags = SPI_DEVICE_NO_DUMMY;
+    return spi_bus_add_device(_host, &dev, &_dev) == ESP_OK;
+  }
+
+  void start(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *pixels) override {
+    uint32_t n = (uint32_t)w * h;
+    // The panel takes RGB565 high byte first
+    for (uint32_t i = 0; i < n; i++) pixels[i] = (pixels[i] << 8) | (pixels[i] >> 8);
+    _display.startWrite();
+    _display.setAddrWindow(x, y, w, h);
+    memset(&_trans, 0, sizeof(_trans));
+    _trans.length = n * 16;
+    _trans.tx_buffer = pixels;
+    _active = true;
+    if (spi_device_queue_trans(_dev, &_trans, portMAX_DELAY) != ESP_OK) complete();
+  }
+
+  bool busy() override {
+    spi_transaction_t *done;
+    if (_active && spi_device_get_trans_result(_dev, &done, 0) == ESP_OK) complete();
+    return _active;
+  }
+
+  void wait() override {
+    spi_transaction_t *done;
+    if (_active && spi_device_get_trans_result(_dev, &done, portMAX_DELAY) == ESP_OK) complete();
+  }
+
+private:
+  void complete() {
+    _display.endWrite();
+    _active = false;
+    finished();
+  }
+
+  Display &_display;
+  spi_host_device_t _host;
+  int8_t _mosi, _sclk;
+  uint32_t _hz;
+  uint8_t _mode;
+  spi_device_handle_t _dev;
+  spi_transaction_t _trans;
+  bool _active;
+};
+#endif
+
+#endif // ROBOEYES_DMA_H
@@ -0,0 +1,172 @@
+/***************************************************
+ * RoboEyesDrawList.h - Recorded draw operations
+ * drawEyes() records its primitives here instead of
+ * sending them straight to the panel. The list knows the
+ * box and signature of every slot (for dirty tracking);
+ * RoboEyesSpans.h turns it into final scanline runs.
+ ***************************************************/
+
+#ifndef ROBOEYES_DRAWLIST_H
+#define ROBOEYES_DRAWLIST_H
+
+#include <Arduino.h>
+#include "RoboEyesDirty.h"
+
+enum EyeDrawOpKind {
+  EYE_OP_FILL_RECT,
+  EYE_OP_FILL_ROUND_RECT,
+  EYE_OP_FILL_TRIANGLE
+};
+
+struct EyeDrawOp {
+  uint8_t kind;
+  uint8_t slot;
+  uint16_t color;
+  int16_t a[6];      // x,y,w,h,r | x0,y0,x1,y1,x2,y2
+  DirtyRect bounds;  // pixels the op can touch
+};
+
+class EyeDrawList {
+public:
+  static const uint8_t MAX_OPS = 48;
+
+  EyeDrawList() : _count(0) {}
+
+  void clear() { _count = 0; }
+  uint8_t count() const { return _count; }
+  const EyeDrawOp &operator[](uint8_t i) const { return _ops[i]; }
+
+  void fillRect(uint8_t slot, int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    // Same negative-size convention as Adafruit_SPITFT
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    if (w == 0 || h == 0) return;
+    EyeDrawOp *op = push(EYE_OP_FILL_RECT, slot, color);
+    if (!op) return;
+    op->a[0] = x; op->a[1] = y; op->a[2] = w; op->a[3] = h;
+    op->bounds.x = x; op->bounds.y = y; op->bounds.w = w; op->bounds.h = h;
+  }
+
+  void fillRoundRect(uint8_t slot, int16_t x, int16_t y, int16_t w, int16_t h, int16_t r, uint16_t color) {
+    // Adafruit_GFX draws nothing for empty boxes
+    if (w <= 0 || h <= 0) return;
+    EyeDrawOp *op = push(EYE_OP_FILL_ROUND_RECT, slot, color);
+    if (!op) return;
+    op->a[0] = x; op->a[1] = y; op->a[2] = w; op->a[3] = h; op->a[4] = r;
+    op->bounds.x = x; op->bounds.y = y; op->bounds.w = w; op->bounds.h = h;
+  }
+
+  void fillTriangle(uint8_t slot, int16_t x0, int16_t y0, int16_t x1, int16_t y1,
+                    int16_t x2, int16_t y2, uint16_t color) {
+    EyeDrawOp *op = push(EYE_OP_FILL_TRIANGLE, slot, color);
+    if (!op) return;
+    op->a[0] = x0; op->a[1] = y0; op->a[2] = x1; op->a[3] = y1; op->a[4] = x2; op->a[5] = y2;
+    int16_t minX = min(x0, min(x1, x2)), maxX = max(x0, max(x1, x2));
+    int16_t minY = min(y0, min(y1, y2)), maxY = max(y0, max(y1, y2));
+    op->bounds.x = minX; op->bounds.y = minY;
+    op->bounds.w = maxX - minX + 1; op->bounds.h = maxY - minY + 1;
+  }
+
+  // Shrink the region of the last op to what it can visibly change, e.g. a
+  // background-coloured overlay that only matters where it covers the eye
+  void limitBounds(int16_t x, int16_t y, int16_t w, int16_t h) {
+    if (_count == 0) return;
+    DirtyRect &b = _ops[_count - 1].bounds;
+    int16_t x2 = min((int16_t)(b.x + b.w), (int16_t)(x + w));
+    int16_t y2 = min((int16_t)(b.y + b.h), (int16_t)(y + h));
+    b.x = max(b.x, x);
+    b.y = max(b.y, y);
+    b.w = max((int16_t)0, (int16_t)(x2 - b.x));
+    b.h = max((int16_t)0, (int16_t)(y2 - b.y));
+  }
+
+  // Box covered by all ops of a slot (unclipped; empty if the slot drew nothing)
+  DirtyRect slotBounds(uint8_t slot) const {
+    DirtyRect r = { 0, 0, 0, 0 };
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_ops[i].slot == slot) r.unite(_ops[i].bounds);
+    }
+    return r;
+  }
+
+  // Index of the first op of a slot, -1 if it drew nothing
+  int8_t firstOf(uint8_t slot) const {
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_ops[i].slot == slot) return i;
+    }
+    return -1;
+  }
+
+  // Box covered by every op (unclipped)
+  DirtyRect bounds() const {
+    DirtyRect r = { 0, 0, 0, 0 };
+    for (uint8_t i = 0; i < _count; i++) r.unite(_ops[i].bounds);
+    return r;
+  }
+
+  // Move every op by (dx, dy)
+  void translate(int16_t dx, int16_t dy) {
+    for (uint8_t i = 0; i < _count; i++) {
+      EyeDrawOp &op = _ops[i];
+      op.a[0] += dx; op.a[1] += dy;
+      if (op.kind == EYE_OP_FILL_TRIANGLE) {
+        op.a[2] += dx; op.a[3] += dy;
+        op.a[4] += dx; op.a[5] += dy;
+      }
+      op.bounds.x += dx; op.bounds.y += dy;
+    }
+  }
+
+  // FNV-1a over everything a slot drew; equal signatures mean equal pixels
+  uint32_t slotSignature(uint8_t slot) const {
+    uint32_t h = 2166136261UL;
+    for (uint8_t i = 0; i < _count; i++) {
+      const EyeDrawOp &op = _ops[i];
+      if (op.slot != slot) continue;
+      h = (h ^ op.kind) * 16777619UL;
+      h = (h ^ op.color) * 16777619UL;
+      for (uint8_t k = 0; k < 6; k++) h = (h ^ (uint16_t)op.a[k]) * 16777619UL;
+    }
+    return h;
+  }
+
+  // True if every slot drew the same ops as in prev, only moved: same kinds,
+  // colours, sizes and order, all coordinates of a slot shifted by one
+  // offset (each slot may have its own). Nothing but edges changes then.
+  bool isTranslationOf(const EyeDrawList &prev) const {
+    if (_count != prev._count) return false;
+    for (uint8_t i = 0; i < _count; i++) {
+      const EyeDrawOp &op = _ops[i], &was = prev._ops[i];
+      if (op.kind != was.kind || op.slot != was.slot || op.color != was.color) return false;
+      // The slot's offset is set by its first op
+      uint8_t first = 0;
+      while (_ops[first].slot != op.slot) first++;
+      int16_t dx = _ops[first].a[0] - prev._ops[first].a[0];
+      int16_t dy = _ops[first].a[1] - prev._ops[first].a[1];
+      if (op.a[0] != was.a[0] + dx || op.a[1] != was.a[1] + dy) return false;
+      if (op.kind == EYE_OP_FILL_TRIANGLE) {
+        if (op.a[2] != was.a[2] + dx || op.a[3] != was.a[3] + dy ||
+            op.a[4] != was.a[4] + dx || op.a[5] != was.a[5] + dy) return false;
+      } else if (op.a[2] != was.a[2] || op.a[3] != was.a[3] || op.a[4] != was.a[4]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  EyeDrawOp *push(uint8_t kind, uint8_t slot, uint16_t color) {
+    if (_count >= MAX_OPS) return NULL;
+    EyeDrawOp *op = &_ops[_count++];
+    op->kind = kind;
+    op->slot = slot;
+    op->color = color;
+    memset(op->a, 0, sizeof(op->a));
+    return op;
+  }
+
+  EyeDrawOp _ops[MAX_OPS];
+  uint8_t _count;
+};
+
+#endif // ROBOEYES_DRAWLIST_H
@@ -0,0 +1,126 @@
+/***************************************************
+ * RoboEyesFixed.h - Numeric type for animation math
+ * EyeReal is float by default. Build with
+ * ROBOEYES_FIXED_MATH defined and it becomes a Q16.16
+ * fixed-point number, so interpolation, easing and
+ * LFOs run on integer ops on boards without an FPU
+ * (ESP32-C3, ESP8266). Sine comes from a table then.
+ ***************************************************/
+
+#ifndef ROBOEYES_FIXED_H
+#define ROBOEYES_FIXED_H
+
+#include <Arduino.h>
+
+#ifdef ROBOEYES_FIXED_MATH
+
+#include <type_traits>
+
+class EyeFixed {
+public:
+  static const int32_t ONE = 65536L;
+
+  // Integers outside -32768..32767 (a millis() value, say) saturate
+  EyeFixed() : v(0) {}
+  EyeFixed(int i) : v(whole((long)i)) {}
+  EyeFixed(unsigned int i) : v(whole((unsigned long)i)) {}
+  EyeFixed(long i) : v(whole(i)) {}
+  EyeFixed(unsigned long i) : v(whole(i)) {}
+  // Literals fold at compile time; runtime floats only come in through setters
+  EyeFixed(float f) : v((int32_t)(f * ONE + (f < 0 ? -0.5f : 0.5f))) {}
+  EyeFixed(double f) : v((int32_t)(f * ONE + (f < 0 ? -0.5 : 0.5))) {}
+
+  static EyeFixed raw(int32_t r) { EyeFixed f; f.v = r; return f; }
+  int32_t raw() const { return v; }
+
+  // To any integer type: truncates toward zero, like a float to int conversion
+  template<typename T> explicit operator T() const { return (T)(v < 0 ? -(-v >> 16) : v >> 16); }
+
+  EyeFixed operator-() const { return raw(-v); }
+  EyeFixed &operator+=(EyeFixed o) { v += o.v; return *this; }
+  EyeFixed &operator-=(EyeFixed o) { v -= o.v; return *this; }
+  EyeFixed &operator*=(EyeFixed o) { v = (int32_t)(((int64_t)v * o.v) >> 16); return *this; }
+  // Rounds to nearest, so 1 / 10 is the same value as the literal 0.1
+  EyeFixed &operator/=(EyeFixed o) {
+    int64_t n = (int64_t)v << 16;
+    int32_t half = ((n < 0) != (o.v < 0)) ? -(o.v / 2) : o.v / 2;
+    v = (int32_t)((n + half) / o.v);
+    return *this;
+  }
+
+  friend EyeFixed operator+(EyeFixed a, EyeFixed b) { return a += b; }
+  friend EyeFixed operator-(EyeFixed a, EyeFixed b) { return a -= b; }
+  friend EyeFixed operator*(EyeFixed a, EyeFixed b) { return a *= b; }
+  friend EyeFixed operator/(EyeFixed a, EyeFixed b) { return a /= b; }
+  friend bool operator<(EyeFixed a, EyeFixed b) { return a.v < b.v; }
+  friend bool operator>(EyeFixed a, EyeFixed b) { return a.v > b.v; }
+  friend bool operator<=(EyeFixed a, EyeFixed b) { return a.v <= b.v; }
+  friend bool operator>=(EyeFixed a, EyeFixed b) { return a.v >= b.v; }
+  friend bool operator==(EyeFixed a, EyeFixed b) { return a.v == b.v; }
+  friend bool operator!=(EyeFixed a, EyeFixed b) { return a.v != b.v; }
+
+private:
+  static int32_t whole(long i) {
+    if (i > 32767) return 0x7FFFFFFFL;
+    if (i < -32768) return -0x7FFFFFFFL - 1;
+    return (int32_t)i * ONE;
+  }
+  static int32_t whole(unsigned long i) { return i > 32767 ? 0x7FFFFFFFL : (int32_t)i * ONE; }
+
+  int32_t v;
+};
+
+// Integer state eased by a fixed-point step (x += d * alpha) keeps float's
+// semantics: the sum is formed first, then truncated
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value, T &>::type operator+=(T &lhs, EyeFixed rhs) {
+  return lhs = (T)(int)(EyeFixed((long)lhs) + rhs);
+}
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value, T &>::type operator-=(T &lhs, EyeFixed rhs) {
+  return lhs = (T)(int)(EyeFixed((long)lhs) - rhs);
+}
+
+#ifndef abs
+inline EyeFixed abs(EyeFixed f) { return f < 0 ? -f : f; }
+#endif
+
+typedef EyeFixed EyeReal;
+
+// Quarter sine wave, Q1.15, 65 entries (0..90 degrees)
+static const uint16_t EYE_SINE_QUARTER[65] PROGMEM = {
+      0,   804,  1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+  12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+  23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+  30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+  32767
+};
+
+// sin(2 * PI * (t % period) / period) from the table, linearly interpolated
+inline EyeReal eyeSinCycle(unsigned long t, unsigned long period) {
+  // Full turn = 65536; periods past 65535 ms need 64 bits for the shift
+  unsigned long phase = t % period;
+  uint16_t angle = period <= 0xFFFFUL ? (uint16_t)(((uint32_t)phase << 16) / period)
+                                      : (uint16_t)(((uint64_t)phase << 16) / period);
+  uint8_t quadrant = angle >> 14;
+  uint16_t a = angle & 0x3FFF;
+  if (quadrant & 1) a = 0x4000 - a;
+  uint8_t i = a >> 8;
+  int32_t s = pgm_read_word(&EYE_SINE_QUARTER[i]);
+  if (i < 64) s += ((int32_t)(pgm_read_word(&EYE_SINE_QUARTER[i + 1]) - s) * (a & 0xFF)) >> 8;
+  if (quadrant & 2) s = -s;
+  return EyeFixed::raw(s << 1);  // Q1.15 -> Q16.16
+}
+
+#else
+
+typedef float EyeReal;
+
+inline EyeReal eyeSinCycle(unsigned long t, unsigned long period) {
+  float phase = (2.0f * PI * (float)(t % period)) / (float)period;
+  return sin(phase);
+}
+
+#endif // ROBOEYES_FIXED_MATH
+
+#endif // ROBOEYES_FIXED_H
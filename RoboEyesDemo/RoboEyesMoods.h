@@ -0,0 +1,118 @@
+/***************************************************
+ * RoboEyesMoods.h - Mood table for the V2 eyes
+ * Every mood is one constant row: eye size, which
+ * eyelid it lowers and how far, and how its idle
+ * animation moves. All eyelids live in one vector
+ * that is eased toward its target as a whole.
+ ***************************************************/
+
+#ifndef ROBOEYES_MOODS_H
+#define ROBOEYES_MOODS_H
+
+#include <Arduino.h>
+#include "RoboEyesFixed.h"
+
+// Eyelids, in drawing order
+enum {
+  LID_TIRED, LID_ANGRY, LID_HAPPY, LID_SAD, LID_GLEE, LID_WORRIED, LID_FOCUSED,
+  LID_ANNOYED, LID_SKEPTIC, LID_FRUSTRATED, LID_SUSPICIOUS, LID_SQUINT, LID_FURIOUS,
+  LID_COUNT,
+  LID_NONE = LID_COUNT
+};
+
+// How an eyelid cuts into the eye (low nibble of its style)
+enum {
+  LID_SHAPE_OUTER,   // triangle, deepest at the outer corner
+  LID_SHAPE_INNER,   // triangle, deepest at the inner corner
+  LID_SHAPE_MIDDLE,  // triangle, deepest in the middle
+  LID_SHAPE_FLAT,    // straight cut from the top
+  LID_SHAPE_BOTTOM   // rounded cut from below (value = offset from the bottom)
+};
+#define LID_SHAPE_MASK  0x0F
+#define LID_LEFT_ONLY   0x10  // left eye only
+#define LID_CYCLOPS     0x20  // also drawn in cyclops mode (triangles split in two)
+
+static const uint8_t EYE_LID_STYLES[LID_COUNT] PROGMEM = {
+  LID_SHAPE_OUTER | LID_CYCLOPS,                   // tired
+  LID_SHAPE_INNER | LID_CYCLOPS,                   // angry
+  LID_SHAPE_BOTTOM | LID_CYCLOPS,                  // happy
+  LID_SHAPE_OUTER,                                 // sad
+  LID_SHAPE_BOTTOM | LID_CYCLOPS,                  // glee
+  LID_SHAPE_MIDDLE,                                // worried
+  LID_SHAPE_FLAT,                                  // focused
+  LID_SHAPE_OUTER,                                 // annoyed
+  LID_SHAPE_FLAT | LID_LEFT_ONLY | LID_CYCLOPS,    // skeptic
+  LID_SHAPE_FLAT,                                  // frustrated
+  LID_SHAPE_FLAT,                                  // suspicious
+  LID_SHAPE_FLAT,                                  // squint
+  LID_SHAPE_INNER                                  // furious
+};
+
+// One value per eyelid: top lids in pixels closed, bottom lids in pixels raised
+struct EyeLidVector {
+  byte h[LID_COUNT];
+
+  void clear() { memset(h, 0, sizeof(h)); }
+
+  // Every lid a step of alpha toward target
+  void easeToward(const EyeLidVector &target, EyeReal alpha) {
+    for (uint8_t i = 0; i < LID_COUNT; i++) h[i] += (target.h[i] - h[i]) * alpha;
+  }
+
+  // True while any lid is more than tolerance away from target
+  bool movingToward(const EyeLidVector &target, byte tolerance) const {
+    for (uint8_t i = 0; i < LID_COUNT; i++) {
+      if (abs(h[i] - target.h[i]) > tolerance) return true;
+    }
+    return false;
+  }
+};
+
+// Mood flags
+#define MOOD_ANIMATED     0x01  // runs the per-mood idle animation
+#define MOOD_CLOSES_EYES  0x02  // closes the eyes (sleep)
+#define MOOD_SWELL_HEIGHT 0x04  // animation swells eye heights
+#define MOOD_SWELL_WIDTH  0x08  // animation swells eye widths
+
+struct EyeMood {
+  uint8_t flags;
+  uint8_t sizePct;          // eye width and height, percent of the defaults
+  uint8_t lid;              // LID_* the mood lowers, LID_NONE for none
+  uint8_t lidNum, lidDen;   // ... to default eye height * lidNum / lidDen
+  uint16_t animPeriod;      // ms per animation loop
+  uint16_t lfoPeriod;       // ms per sway cycle
+  uint8_t swayAmp;          // sway, size and lid swing amplitudes, tenths of a pixel
+  uint8_t sizeAmp;
+  uint8_t lidAmp;
+  uint8_t saccadeAmp;       // micro-saccade step, tenths of a pixel
+  uint8_t animLid;          // LID_* the animation swings, LID_NONE for none
+  int8_t animLidHalf;       // swing only while sin > 0 (1), < 0 (-1), or both ways (0)
+  uint8_t animLidTrim;      // tenths of a pixel taken off lidAmp for that swing
+};
+
+// Indexed by mood (DEFAULT .. AWE)
+static const EyeMood EYE_MOODS[] PROGMEM = {
+  //  flags                                                      size lid             lid   anim  lfo   sway size lid  sacc animLid     half trim
+  { MOOD_ANIMATED,                                               100, LID_NONE,       0, 1, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // DEFAULT
+  { MOOD_ANIMATED | MOOD_SWELL_HEIGHT,                           100, LID_HAPPY,      1, 4,  900, 1500, 12, 20, 30, 10, LID_HAPPY,   0,  0 },  // HAPPY
+  { MOOD_ANIMATED,                                               100, LID_SAD,        1, 4, 1200, 2200, 10, 15, 20, 10, LID_SAD,     1, 10 },  // SAD
+  { MOOD_ANIMATED,                                               100, LID_ANGRY,      1, 2,  700, 1400,  6, 15, 25, 16, LID_ANGRY,  -1,  5 },  // ANGRY
+  { MOOD_ANIMATED,                                               100, LID_TIRED,      1, 3, 1400, 2800, 16, 12, 16,  6, LID_TIRED,  -1, 14 },  // TIRED
+  { MOOD_CLOSES_EYES,                                            100, LID_NONE,       0, 1, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // SLEEP
+  { MOOD_ANIMATED | MOOD_SWELL_HEIGHT,                           100, LID_GLEE,       1, 3,  900, 1500, 12, 20, 30, 10, LID_HAPPY,   0,  0 },  // GLEE
+  { MOOD_ANIMATED,                                               100, LID_WORRIED,    1, 5, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // WORRIED
+  { MOOD_ANIMATED,                                               100, LID_FOCUSED,    1, 4, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // FOCUSED
+  { MOOD_ANIMATED,                                               100, LID_ANNOYED,    1, 5, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // ANNOYED
+  { MOOD_ANIMATED | MOOD_SWELL_HEIGHT | MOOD_SWELL_WIDTH,        130, LID_NONE,       0, 1,  800, 1600,  8, 22, 22, 10, LID_NONE,    0,  0 },  // SURPRISED
+  { MOOD_ANIMATED,                                               100, LID_SKEPTIC,    1, 3, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // SKEPTIC
+  { MOOD_ANIMATED,                                               100, LID_FRUSTRATED, 1, 4, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // FRUSTRATED
+  { MOOD_ANIMATED,                                               100, LID_SUSPICIOUS, 1, 3, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // SUSPICIOUS
+  { MOOD_ANIMATED,                                               100, LID_SQUINT,     2, 5, 1000, 2000,  8, 16, 20, 10, LID_NONE,    0,  0 },  // SQUINT
+  { MOOD_ANIMATED,                                               100, LID_FURIOUS,    1, 2,  700, 1400,  6, 15, 25, 16, LID_ANGRY,  -1,  5 },  // FURIOUS
+  { MOOD_ANIMATED,                                               120, LID_NONE,       0, 1,  800, 1600,  8, 22, 22, 10, LID_NONE,    0,  0 },  // SCARED
+  { MOOD_ANIMATED | MOOD_SWELL_HEIGHT | MOOD_SWELL_WIDTH,        140, LID_NONE,       0, 1,  800, 1600,  8, 22, 22, 10, LID_NONE,    0,  0 }   // AWE
+};
+
+#define EYE_MOOD_COUNT (sizeof(EYE_MOODS) / sizeof(EYE_MOODS[0]))
+
+#endif // ROBOEYES_MOODS_H
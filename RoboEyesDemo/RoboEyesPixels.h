@@ -0,0 +1,159 @@
+/***************************************************
+ * RoboEyesPixels.h - Pixel format on the wire
+ * The eyes only use two colours, so most of RGB565's
+ * precision is never seen. With the panel in 12 bpp
+ * (COLMOD RGB444) two pixels go out in three bytes, a
+ * quarter less SPI traffic. EyePixelWriter packs the
+ * flushes that way and switches the panel back to
+ * RGB565 after each, so Adafruit_GFX drawing (the eyes'
+ * own direct path, the sketch) still works in between.
+ * Colours are quantized to what RGB444 can show, so
+ * both formats paint the same values.
+ ***************************************************/
+
+#ifndef ROBOEYES_PIXELS_H
+#define ROBOEYES_PIXELS_H
+
+#include <Arduino.h>
+
+enum EyePixelFormat {
+  EYE_PIXELS_RGB565,  // 16 bpp, as Adafruit_GFX sends them
+  EYE_PIXELS_RGB444   // 12 bpp, two pixels in three bytes
+};
+
+#define EYE_PIXELS_COLMOD     0x3A
+#define EYE_PIXELS_COLMOD_565 0x55
+#define EYE_PIXELS_COLMOD_444 0x53
+
+// Nearest colour RGB444 can show, as RGB565
+inline uint16_t eyeQuantize444(uint16_t c) {
+  uint16_t r = ((c >> 11) * 15 + 15) / 31;
+  uint16_t g = (((c >> 5) & 0x3F) * 15 + 31) / 63;
+  uint16_t b = ((c & 0x1F) * 15 + 15) / 31;
+  return ((r << 1 | r >> 3) << 11) | ((g << 2 | g >> 2) << 5) | (b << 1 | b >> 3);
+}
+
+template<typename Display>
+class EyePixelWriter {
+public:
+  explicit EyePixelWriter(Display &display) : _display(display), _format(EYE_PIXELS_RGB565), _used(0), _pushed(0) {}
+
+  void setFormat(uint8_t format) { _format = format; }
+  uint8_t format() const { return _format; }
+  bool packed() const { return _format == EYE_PIXELS_RGB444; }
+
+  // The colour the panel ends up showing for c
+  uint16_t quantize(uint16_t c) const { return packed() ? eyeQuantize444(c) : c; }
+
+  // Around a run of span() calls: the panel takes packed pixels in between.
+  // Outside startWrite()/endWrite(), sendCommand() opens its own transaction.
+  void begin() { if (packed()) colmod(EYE_PIXELS_COLMOD_444); }
+  void end() { if (packed()) colmod(EYE_PIXELS_COLMOD_565); }
+
+  // Span sink (RoboEyesSpans.h) for the run x..x+w-1 of row y, already
+  // clipped; inside startWrite()/endWrite()
+  void span(int16_t x, int16_t y, int16_t w, uint16_t color) {
+    if (!packed()) {
+      _display.writeFastHLine(x, y, w, color);
+      return;
+    }
+    _display.setAddrWindow(x, y, w, 1);
+    // One colour repeats every three bytes; a last group of four pixels
+    // running past the window wraps onto its first pixels, same colour
+    uint8_t *bytes = (uint8_t *)_buf;
+    uint8_t r = color >> 12, g = (color >> 7) & 0x0F, b = (color >> 1) & 0x0F;
+    uint16_t groups = (w + 3) / 4;
+    uint16_t fill = min(groups, (uint16_t)GROUPS) * 6;
+    for (uint16_t i = 0; i < fill; i += 3) {
+      bytes[i] = r << 4 | g;
+      bytes[i + 1] = b << 4 | r;
+      bytes[i + 2] = g << 4 | b;
+    }
+    while (groups) {
+      uint16_t n = min(groups, (uint16_t)GROUPS);
+      send(n);
+      groups -= n;
+    }
+  }
+
+  // Same call as Adafruit_GFX's for a pre-clipped w x h block of RGB565, so
+  // it can stand in for the display (RoboEyesCanvas::flush())
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *colors, int16_t w, int16_t h) {
+    if (!packed()) {
+      _display.drawRGBBitmap(x, y, colors, w, h);
+      return;
+    }
+    open(x, y, w, h);
+    push(colors, (uint32_t)w * h);
+    close();
+  }
+
+  // A pre-clipped w x h window whose pixels come in row order from any
+  // number of push() calls (e.g. expanded a few at a time); close() ends it.
+  // Opens and closes a transaction of its own.
+  void open(int16_t x, int16_t y, int16_t w, int16_t h) {
+    begin();
+    _display.startWrite();
+    _display.setAddrWindow(x, y, w, h);
+    _pushed = 0;
+    _used = 0;
+  }
+
+  void push(const uint16_t *colors, uint32_t n) {
+    if (!packed()) {
+      _display.writePixels((uint16_t *)colors, n);
+      return;
+    }
+    while (n--) add(*colors++);
+  }
+
+  void close() {
+    if (packed()) {
+      // Whole groups of four: pixels past the end wrap onto the window's
+      // first ones, which get their own colour again
+      uint32_t n = _pushed;
+      while (_used % 4) add(_first[_pushed % n]);
+      if (_used) send(_used / 4);
+    }
+    _display.endWrite();
+    end();
+  }
+
+private:
+  static const uint16_t GROUPS = 32;  // groups of four pixels (six bytes) per transfer
+
+  // One RGB565 pixel into the packed buffer: even pixels take a byte and a
+  // half, odd ones the other half and a byte
+  void add(uint16_t c) {
+    if (_pushed < 3) _first[_pushed] = c;
+    _pushed++;
+    uint8_t *p = (uint8_t *)_buf + (_used >> 1) * 3;
+    uint8_t r = c >> 12, g = (c >> 7) & 0x0F, b = (c >> 1) & 0x0F;
+    if (_used & 1) {
+      p[1] = (p[1] & 0xF0) | r;
+      p[2] = g << 4 | b;
+    } else {
+      p[0] = r << 4 | g;
+      p[1] = b << 4;
+    }
+    if (++_used == GROUPS * 4) {
+      send(GROUPS);
+      _used = 0;
+    }
+  }
+
+  void colmod(uint8_t mode) { _display.sendCommand(EYE_PIXELS_COLMOD, &mode, 1); }
+
+  // groups * 6 bytes of _buf as they are in memory: writePixels() with
+  // bigEndian set sends 16-bit words without swapping them
+  void send(uint16_t groups) { _display.writePixels(_buf, groups * 3, true, true); }
+
+  Display &_display;
+  uint8_t _format;
+  uint16_t _buf[GROUPS * 3];
+  uint16_t _used;       // pixels in _buf
+  uint32_t _pushed;     // pixels since open()
+  uint16_t _first[3];   // the window's first pixels, for the wrap in close()
+};
+
+#endif // ROBOEYES_PIXELS_H
@@ -0,0 +1,222 @@
+/***************************************************
+ * RoboEyesProfile.h - Per-stage frame profiler
+ * Built with ROBOEYES_PROFILE, the renderers time each
+ * stage of a frame (state update, clear, eyes, eyelids,
+ * sweat, flush) in CPU cycles and count the primitives
+ * and pixels every stage sends, plus a histogram of
+ * whole-frame times and how many frames overran their
+ * interval. Without it EyeProfiler is empty and every
+ * call compiles away; the stats then read all zero.
+ ***************************************************/
+
+#ifndef ROBOEYES_PROFILE_H
+#define ROBOEYES_PROFILE_H
+
+#include <Arduino.h>
+#if defined(ROBOEYES_PROFILE) && !defined(ARDUINO)
+#include <chrono>
+#endif
+
+// Stages of a frame, in drawing order
+enum EyeStage {
+  EYE_STAGE_UPDATE,  // animation and behaviour state
+  EYE_STAGE_CLEAR,   // background over the last frame
+  EYE_STAGE_EYES,    // eye fills
+  EYE_STAGE_LIDS,    // eyelid overlays
+  EYE_STAGE_SWEAT,
+  EYE_STAGE_FLUSH,   // getting the frame to the panel
+  EYE_STAGE_COUNT
+};
+
+// Frame-time histogram: under 1 ms, then buckets twice as wide as the one
+// before, the last one taking everything from 64 ms up
+#define EYE_PROFILE_BUCKETS 8
+
+struct EyeStageStats {
+  uint64_t cycles;      // summed over every pass
+  uint32_t maxCycles;   // worst single pass
+  uint32_t primitives;
+  uint64_t pixels;      // bounding boxes: an upper bound for round shapes
+};
+
+struct EyeFrameStats {
+  uint32_t frames;       // frames drawn
+  uint32_t missed;       // frames whose work took longer than the frame interval
+  uint32_t lastUs;
+  uint32_t maxUs;
+  uint32_t cyclesPerUs;
+  EyeStageStats stages[EYE_STAGE_COUNT];
+  uint32_t histogram[EYE_PROFILE_BUCKETS];
+};
+
+#ifdef ROBOEYES_PROFILE
+
+class EyeProfiler {
+public:
+  EyeProfiler() { reset(); }
+
+  void reset() {
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_pass, 0, sizeof(_pass));
+    _stats.cyclesPerUs = cyclesPerUs();
+    _mark = cycles();
+  }
+
+  // Marks the clock where a pass through update()/drawEyes() begins
+  void start() { _mark = cycles(); }
+
+  // Cycles since the last mark go to stage
+  void lap(uint8_t stage) {
+    uint32_t now = cycles();
+    _pass[stage] += now - _mark;
+    _mark = now;
+  }
+
+  void count(uint8_t stage, uint32_t primitives, uint32_t pixels) {
+    _stats.stages[stage].primitives += primitives;
+    _stats.stages[stage].pixels += pixels;
+  }
+
+  // One primitive covering a w x h box
+  void countRect(uint8_t stage, int16_t w, int16_t h) {
+    count(stage, 1, (w > 0 && h > 0) ? (uint32_t)w * h : 0);
+  }
+
+  // The pass drew a frame: its stages go into the totals, its time into the
+  // histogram, and it is missed if it took longer than intervalMs
+  void endFrame(unsigned long intervalMs) {
+    uint32_t us = fold() / _stats.cyclesPerUs;
+    _stats.frames++;
+    _stats.lastUs = us;
+    if (us > _stats.maxUs) _stats.maxUs = us;
+    if (us > intervalMs * 1000UL) _stats.missed++;
+    uint8_t b = 0;
+    for (uint32_t edge = 1000; b < EYE_PROFILE_BUCKETS - 1 && us >= edge; edge <<= 1) b++;
+    _stats.histogram[b]++;
+  }
+
+  // The pass did work but drew nothing (catch-up steps, an unchanged frame,
+  // DMA pumping): it only adds to the stage totals
+  void end() { fold(); }
+
+  const EyeFrameStats &stats() const { return _stats; }
+
+  // Averages per drawn frame, then the histogram. Out is Serial or anything
+  // with print(const char *) / print(unsigned long) / println().
+  template<typename Out>
+  void dump(Out &out) const {
+    const EyeFrameStats &s = _stats;
+    unsigned long n = s.frames ? s.frames : 1;
+    out.print("frames ");
+    out.print((unsigned long)s.frames);
+    out.print(", missed ");
+    out.print((unsigned long)s.missed);
+    out.print(", last ");
+    out.print((unsigned long)s.lastUs);
+    out.print(" us, worst ");
+    out.print((unsigned long)s.maxUs);
+    out.println(" us");
+    out.println("stage      avg us   max us  prims/f     px/f");
+    for (uint8_t i = 0; i < EYE_STAGE_COUNT; i++) {
+      const EyeStageStats &st = s.stages[i];
+      out.print(stageName(i));
+      column(out, (unsigned long)(st.cycles / n / s.cyclesPerUs), 17 - strlen(stageName(i)));
+      column(out, st.maxCycles / s.cyclesPerUs, 9);
+      column(out, st.primitives / n, 9);
+      column(out, (unsigned long)(st.pixels / n), 9);
+      out.println();
+    }
+    out.print("histogram");
+    for (uint8_t b = 0; b < EYE_PROFILE_BUCKETS; b++) {
+      out.print(b == EYE_PROFILE_BUCKETS - 1 ? "  >=" : "  <");
+      out.print((unsigned long)(b == EYE_PROFILE_BUCKETS - 1 ? 1UL << (b - 1) : 1UL << b));
+      out.print("ms:");
+      out.print((unsigned long)s.histogram[b]);
+    }
+    out.println();
+  }
+
+private:
+  // Adds the pass to the totals; returns its cycles
+  uint32_t fold() {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < EYE_STAGE_COUNT; i++) {
+      EyeStageStats &st = _stats.stages[i];
+      st.cycles += _pass[i];
+      if (_pass[i] > st.maxCycles) st.maxCycles = _pass[i];
+      total += _pass[i];
+      _pass[i] = 0;
+    }
+    return total;
+  }
+
+  static uint32_t cycles() {
+#if defined(ESP32)
+    return ESP.getCycleCount();
+#elif defined(ARDUINO)
+    return micros();
+#else
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  static uint32_t cyclesPerUs() {
+#if defined(ESP32)
+    return getCpuFrequencyMhz();
+#elif defined(ARDUINO)
+    return 1;
+#else
+    return 1000;  // nanoseconds
+#endif
+  }
+
+  static const char *stageName(uint8_t stage) {
+    switch (stage) {
+      case EYE_STAGE_UPDATE: return "update";
+      case EYE_STAGE_CLEAR:  return "clear";
+      case EYE_STAGE_EYES:   return "eyes";
+      case EYE_STAGE_LIDS:   return "lids";
+      case EYE_STAGE_SWEAT:  return "sweat";
+      default:               return "flush";
+    }
+  }
+
+  // v right-aligned in width characters
+  template<typename Out>
+  static void column(Out &out, unsigned long v, uint8_t width) {
+    uint8_t digits = 1;
+    for (unsigned long x = v; x >= 10; x /= 10) digits++;
+    while (width-- > digits) out.print(" ");
+    out.print(v);
+  }
+
+  EyeFrameStats _stats;
+  uint32_t _pass[EYE_STAGE_COUNT];  // cycles of the pass in progress
+  uint32_t _mark;
+};
+
+#else
+
+class EyeProfiler {
+public:
+  void reset() {}
+  void start() {}
+  void lap(uint8_t) {}
+  void count(uint8_t, uint32_t, uint32_t) {}
+  void countRect(uint8_t, int16_t, int16_t) {}
+  void endFrame(unsigned long) {}
+  void end() {}
+
+  const EyeFrameStats &stats() const {
+    static const EyeFrameStats none = EyeFrameStats();
+    return none;
+  }
+
+  template<typename Out>
+  void dump(Out &out) const { out.println("profiler off: build with ROBOEYES_PROFILE"); }
+};
+
+#endif // ROBOEYES_PROFILE
+
+#endif // ROBOEYES_PROFILE_H
@@ -0,0 +1,88 @@
+/***************************************************
+ * RoboEyesQueue.h - Lock-free handoff between cores
+ * EyeSpscQueue carries small commands from one
+ * producer to one consumer; EyeHandoff passes a whole
+ * state (e.g. a QR matrix) by triple buffering, so the
+ * writer never waits for the reader and the reader
+ * always gets the latest complete copy. Neither side
+ * takes a lock. Needs <atomic> (ESP32, host).
+ ***************************************************/
+
+#ifndef ROBOEYES_QUEUE_H
+#define ROBOEYES_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Ring of SIZE - 1 usable slots, SIZE a power of two. push() only from the
+// producer, pop() only from the consumer.
+template<typename T, uint16_t SIZE>
+class EyeSpscQueue {
+public:
+  EyeSpscQueue() : _head(0), _tail(0) {}
+
+  // False (and nothing queued) when full
+  bool push(const T &item) {
+    uint16_t head = _head.load(std::memory_order_relaxed);
+    uint16_t next = (head + 1) & (SIZE - 1);
+    if (next == _tail.load(std::memory_order_acquire)) return false;
+    _items[head] = item;
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // False when empty
+  bool pop(T &item) {
+    uint16_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return false;
+    item = _items[tail];
+    _tail.store((tail + 1) & (SIZE - 1), std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+  }
+
+private:
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "EyeSpscQueue size must be a power of two");
+
+  T _items[SIZE];
+  std::atomic<uint16_t> _head;  // next slot the producer writes
+  std::atomic<uint16_t> _tail;  // next slot the consumer reads
+};
+
+// Three copies of T: one the writer fills, one the reader holds, one in
+// between. publish() swaps the filled copy into the middle, acquire()
+// swaps the middle copy out if it is newer than the one held.
+template<typename T>
+class EyeHandoff {
+public:
+  EyeHandoff() : _back(0), _middle(1), _front(2) {}
+
+  // Writer side: fill back(), then publish() it
+  T &back() { return _slots[_back]; }
+  void publish() {
+    _back = _middle.exchange(_back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // Reader side: true if a newer copy was published since the last call;
+  // front() is the latest copy either way
+  bool acquire() {
+    if (!(_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & INDEX;
+    return true;
+  }
+  const T &front() const { return _slots[_front]; }
+
+private:
+  static const uint8_t INDEX = 0x03;
+  static const uint8_t FRESH = 0x04;  // middle holds a copy the reader has not seen
+
+  T _slots[3];
+  uint8_t _back;                 // writer only
+  std::atomic<uint8_t> _middle;
+  uint8_t _front;                // reader only
+};
+
+#endif // ROBOEYES_QUEUE_H
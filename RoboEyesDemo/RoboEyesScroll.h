@@ -0,0 +1,106 @@
+/***************************************************
+ * RoboEyesScroll.h - Whole-face motion by hardware scroll
+ * MIPI panels (ST7789, ILI9341) can show their frame
+ * memory rotated along the scan lines: VSCRDEF makes
+ * all 320 lines one scroll area, VSCSAD picks the line
+ * shown first. A frame whose face only moved along that
+ * axis (laugh, flicker, sway) is then kept where memory
+ * already holds it, and one 2-byte command moves it on
+ * screen instead of repainting the eyes.
+ * The direction for each rotation comes from the
+ * MADCTL bits Adafruit_ST7789 sets and the datasheet's
+ * VSCSAD, checked against the host's emulation only,
+ * not yet on a panel. The whole screen moves, sweat
+ * drops included, so a wrong sign shows at once: if
+ * the face runs the wrong way, build with
+ * ROBOEYES_SCROLL_FLIP.
+ ***************************************************/
+
+#ifndef ROBOEYES_SCROLL_H
+#define ROBOEYES_SCROLL_H
+
+#include <Arduino.h>
+#include "RoboEyesDrawList.h"
+
+// Lines of frame memory the scroll rotates (240x320 ST7789 / ILI9341)
+#ifndef ROBOEYES_SCROLL_LINES
+#define ROBOEYES_SCROLL_LINES 320
+#endif
+
+#define EYE_SCROLL_VSCRDEF 0x33  // vertical scrolling definition
+#define EYE_SCROLL_VSCSAD  0x37  // vertical scroll start address
+
+class EyeHardwareScroll {
+public:
+  EyeHardwareScroll() : _lines(0), _alongX(false), _reversed(false), _shown(0) {}
+
+  // Scroll along the screen axis the panel scans for the display's current
+  // rotation: y in portrait, x in landscape. False if that axis does not
+  // span the whole frame memory (other panel sizes); nothing is sent then.
+  template<typename Display>
+  bool begin(Display &display, int16_t screenW, int16_t screenH) {
+    uint8_t rotation = display.getRotation();
+    _alongX = rotation & 1;
+    _reversed = rotation < 2;  // Adafruit_ST7789 sets MY for rotations 0 and 1
+#ifdef ROBOEYES_SCROLL_FLIP
+    _reversed = !_reversed;
+#endif
+    _lines = (along(screenW, screenH) == ROBOEYES_SCROLL_LINES) ? ROBOEYES_SCROLL_LINES : 0;
+    if (!_lines) return false;
+    uint8_t area[6] = { 0, 0, (uint8_t)(_lines >> 8), (uint8_t)(_lines & 0xFF), 0, 0 };
+    display.sendCommand(EYE_SCROLL_VSCRDEF, area, 6);
+    write(display, 0);
+    return true;
+  }
+
+  // Back to unscrolled, and off
+  template<typename Display>
+  void end(Display &display) {
+    show(display, 0);
+    _lines = 0;
+  }
+
+  bool active() const { return _lines != 0; }
+  int16_t shown() const { return _shown; }
+
+  // The component of a motion (dx, dy) that the scroll can carry
+  int16_t along(int16_t dx, int16_t dy) const { return _alongX ? dx : dy; }
+
+  // Hold the frame in memory offset pixels back along the axis, so that
+  // show(offset) puts it where it was recorded. Only if the frame stays on
+  // screen both ways: what scrolls off one edge comes back in at the other.
+  // Returns the offset the frame is held at (0: not moved).
+  int16_t hold(EyeDrawList &list, int16_t offset) const {
+    if (!_lines || offset == 0) return 0;
+    DirtyRect b = list.bounds();
+    int16_t lo = along(b.x, b.y), hi = lo + along(b.w, b.h);
+    if (lo < max((int16_t)0, offset) || hi > min((int16_t)_lines, (int16_t)(_lines + offset))) return 0;
+    list.translate(_alongX ? -offset : 0, _alongX ? 0 : -offset);
+    return offset;
+  }
+
+  // Show memory moved offset pixels along the axis
+  template<typename Display>
+  void show(Display &display, int16_t offset) {
+    if (_lines && offset != _shown) write(display, offset);
+  }
+
+private:
+  template<typename Display>
+  void write(Display &display, int16_t offset) {
+    _shown = offset;
+    // Line l shows memory line l + start: moving the picture down the scan
+    // lines takes a start that far back
+    int16_t lines = _reversed ? offset : -offset;
+    uint16_t start = (uint16_t)(((lines % (int16_t)_lines) + _lines) % _lines);
+    uint8_t data[2] = { (uint8_t)(start >> 8), (uint8_t)(start & 0xFF) };
+    display.sendCommand(EYE_SCROLL_VSCSAD, data, 2);
+  }
+
+  uint16_t _lines;   // 0 = off
+  bool _alongX;      // landscape: screen x runs along the scan lines
+  bool _reversed;    // screen coordinate runs against the scan order
+  int16_t _shown;    // offset the panel shows
+};
+
+#endif // ROBOEYES_SCROLL_H
@@ -0,0 +1,220 @@
+/***************************************************
+ * RoboEyesSpans.h - Scanline span rasterizer
+ * Resolves a recorded frame row by row: background,
+ * then every op in drawing order (eye, lid cutouts,
+ * sweat) painted as [x0, x1) intervals. Each row of a
+ * region then goes out as its final runs, so no pixel
+ * is written twice; renderDelta() sends only the runs
+ * that differ from the previous frame. Row coverage
+ * matches Adafruit_GFX's fillRoundRect / fillTriangle
+ * pixel for pixel; corner rows come from precomputed
+ * tables (RoboEyesCorners.h).
+ ***************************************************/
+
+#ifndef ROBOEYES_SPANS_H
+#define ROBOEYES_SPANS_H
+
+#include <Arduino.h>
+#include "RoboEyesDrawList.h"
+#include "RoboEyesCorners.h"
+
+class EyeSpanRasterizer {
+public:
+  struct Run {
+    int16_t x0, x1;
+    uint16_t color;
+  };
+
+  // Build the corner tables for radii up to maxRadius (larger ones still
+  // work, but walk the circle on every row)
+  bool begin(uint8_t maxRadius) { return _corners.begin(maxRadius); }
+
+  // Paint clip exactly once: calls sink.span(x, y, w, color) for every final
+  // run, left to right and top to bottom
+  template<typename Sink>
+  void render(const EyeDrawList &list, const DirtyRect &clip, uint16_t bg, Sink &sink) {
+    if (clip.empty()) return;
+    uint8_t ops[EyeDrawList::MAX_OPS];
+    uint8_t opCount = opsIn(list, clip, ops);
+
+    for (int16_t y = clip.y; y < clip.y + clip.h; y++) {
+      rasterRow(list, ops, opCount, clip, y, bg);
+
+      // Neighbouring runs of one colour go out together
+      uint8_t i = 0;
+      while (i < _runCount) {
+        int16_t x0 = _runs[i].x0, x1 = _runs[i].x1;
+        uint16_t color = _runs[i].color;
+        while (++i < _runCount && _runs[i].color == color) x1 = _runs[i].x1;
+        sink.span(x0, y, x1 - x0, color);
+      }
+    }
+  }
+
+  // Paint only the pixels of clip where list differs from prev, the frame
+  // already on the panel there. For a shape that merely moved that is the
+  // sliver it uncovers and the one it newly covers on each row.
+  template<typename Sink>
+  void renderDelta(const EyeDrawList &list, const EyeDrawList &prev, const DirtyRect &clip,
+                   uint16_t bg, Sink &sink) {
+    if (clip.empty()) return;
+    uint8_t ops[EyeDrawList::MAX_OPS], prevOps[EyeDrawList::MAX_OPS];
+    uint8_t opCount = opsIn(list, clip, ops);
+    uint8_t prevCount = opsIn(prev, clip, prevOps);
+
+    for (int16_t y = clip.y; y < clip.y + clip.h; y++) {
+      rasterRow(prev, prevOps, prevCount, clip, y, bg);
+      memcpy(_prevRuns, _runs, _runCount * sizeof(Run));
+      rasterRow(list, ops, opCount, clip, y, bg);
+
+      // Both run lists tile the row; walk them together and send what changed,
+      // joining touching pieces of one colour
+      uint8_t i = 0, j = 0;
+      int16_t x = clip.x, end = clip.x + clip.w;
+      int16_t outX0 = 0, outX1 = 0;
+      uint16_t outColor = 0;
+      while (x < end) {
+        while (_prevRuns[i].x1 <= x) i++;
+        while (_runs[j].x1 <= x) j++;
+        int16_t next = min(_prevRuns[i].x1, _runs[j].x1);
+        if (_runs[j].color != _prevRuns[i].color) {
+          if (outX1 == x && outX1 > outX0 && outColor == _runs[j].color) {
+            outX1 = next;
+          } else {
+            if (outX1 > outX0) sink.span(outX0, y, outX1 - outX0, outColor);
+            outX0 = x;
+            outX1 = next;
+            outColor = _runs[j].color;
+          }
+        }
+        x = next;
+      }
+      if (outX1 > outX0) sink.span(outX0, y, outX1 - outX0, outColor);
+    }
+  }
+
+  // Pixels [x0, x1) an op covers on row y; false if it misses the row
+  bool opRow(const EyeDrawOp &op, int16_t y, int16_t &x0, int16_t &x1) const {
+    const int16_t *a = op.a;
+    switch (op.kind) {
+      case EYE_OP_FILL_RECT:
+        if (y < a[1] || y >= a[1] + a[3]) return false;
+        x0 = a[0];
+        x1 = a[0] + a[2];
+        return true;
+      case EYE_OP_FILL_ROUND_RECT:
+        return roundRectRow(a[0], a[1], a[2], a[3], a[4], y, x0, x1);
+      case EYE_OP_FILL_TRIANGLE:
+        return triangleRow(a[0], a[1], a[2], a[3], a[4], a[5], y, x0, x1);
+    }
+    return false;
+  }
+
+private:
+  // Ops of list that can touch clip at all, in drawing order
+  static uint8_t opsIn(const EyeDrawList &list, const DirtyRect &clip, uint8_t *ops) {
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < list.count(); i++) {
+      if (list[i].bounds.intersects(clip)) ops[n++] = i;
+    }
+    return n;
+  }
+
+  // Final runs of row y of clip into _runs: background, then every op
+  void rasterRow(const EyeDrawList &list, const uint8_t *ops, uint8_t opCount,
+                 const DirtyRect &clip, int16_t y, uint16_t bg) {
+    _runs[0].x0 = clip.x;
+    _runs[0].x1 = clip.x + clip.w;
+    _runs[0].color = bg;
+    _runCount = 1;
+
+    for (uint8_t k = 0; k < opCount; k++) {
+      const EyeDrawOp &op = list[ops[k]];
+      if (y < op.bounds.y || y >= op.bounds.y + op.bounds.h) continue;
+      int16_t x0, x1;
+      if (opRow(op, y, x0, x1)) paint(max(x0, clip.x), min(x1, (int16_t)(clip.x + clip.w)), op.color);
+    }
+  }
+
+  bool roundRectRow(int16_t x, int16_t y, int16_t w, int16_t h, int16_t r,
+                    int16_t row, int16_t &x0, int16_t &x1) const {
+    if (row < y || row >= y + h) return false;
+    int16_t maxRadius = ((w < h) ? w : h) / 2;
+    if (r > maxRadius) r = maxRadius;
+    int16_t d = min((int16_t)(row - y), (int16_t)(y + h - 1 - row));
+    int16_t inset = _corners.inset(r, d);
+    x0 = x + inset;
+    x1 = x + w - inset;
+    return x0 < x1;
+  }
+
+  // Same integer stepping as Adafruit_GFX::fillTriangle(), in closed form
+  static bool triangleRow(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2,
+                          int16_t row, int16_t &left, int16_t &right) {
+    int16_t t;
+    if (y0 > y1) { t = y0; y0 = y1; y1 = t; t = x0; x0 = x1; x1 = t; }
+    if (y1 > y2) { t = y2; y2 = y1; y1 = t; t = x2; x2 = x1; x1 = t; }
+    if (y0 > y1) { t = y0; y0 = y1; y1 = t; t = x0; x0 = x1; x1 = t; }
+    if (row < y0 || row > y2) return false;
+
+    int16_t a, b;
+    if (y0 == y2) {
+      a = b = x0;
+      if (x1 < a) a = x1; else if (x1 > b) b = x1;
+      if (x2 < a) a = x2; else if (x2 > b) b = x2;
+    } else {
+      int16_t last = (y1 == y2) ? y1 : y1 - 1;
+      if (row <= last) a = x0 + (int32_t)(x1 - x0) * (row - y0) / (y1 - y0);
+      else a = x1 + (int32_t)(x2 - x1) * (row - y1) / (y2 - y1);
+      b = x0 + (int32_t)(x2 - x0) * (row - y0) / (y2 - y0);
+      if (a > b) { t = a; a = b; b = t; }
+    }
+    left = a;
+    right = b + 1;
+    return true;
+  }
+
+  // Overwrite [x0, x1) of the current row with color
+  void paint(int16_t x0, int16_t x1, uint16_t color) {
+    if (x0 >= x1) return;
+    Run out[MAX_RUNS];
+    uint8_t n = 0;
+    bool placed = false;
+    for (uint8_t i = 0; i < _runCount; i++) {
+      const Run &r = _runs[i];
+      if (r.x1 <= x0 || r.x0 >= x1) {
+        if (!placed && r.x0 >= x1) {
+          out[n].x0 = x0; out[n].x1 = x1; out[n].color = color; n++;
+          placed = true;
+        }
+        out[n++] = r;
+        continue;
+      }
+      if (r.x0 < x0) { out[n] = r; out[n].x1 = x0; n++; }
+      if (!placed) {
+        out[n].x0 = x0; out[n].x1 = x1; out[n].color = color; n++;
+        placed = true;
+      }
+      if (r.x1 > x1) { out[n] = r; out[n].x0 = x1; n++; }
+    }
+    memcpy(_runs, out, n * sizeof(Run));
+    _runCount = n;
+  }
+
+  // Every op can split one run into three
+  static const uint8_t MAX_RUNS = 2 * EyeDrawList::MAX_OPS + 1;
+  Run _runs[MAX_RUNS];
+  uint8_t _runCount;
+  Run _prevRuns[MAX_RUNS];  // renderDelta(): the row as it is on the panel
+  EyeCornerTable _corners;
+};
+
+// Span sink writing runs as horizontal lines (inside startWrite()/endWrite())
+template<typename GFX>
+struct GfxSpanSink {
+  explicit GfxSpanSink(GFX &target) : gfx(target) {}
+  void span(int16_t x, int16_t y, int16_t w, uint16_t color) { gfx.writeFastHLine(x, y, w, color); }
+  GFX &gfx;
+};
+
+#endif // ROBOEYES_SPANS_H
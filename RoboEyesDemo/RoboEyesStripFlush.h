@@ -0,0 +1,161 @@
+/***************************************************
+ * RoboEyesStripFlush.h - Double-buffered strip flush
+ * Splits the dirty regions of a frame into horizontal
+ * strips. While the DMA backend sends one strip buffer,
+ * the next strip is rendered into the other one. The
+ * done callback may run in an ISR, so it only flags the
+ * end of a transfer; pump() frees that buffer and starts
+ * the next ready strip. The caller has to pump() often
+ * enough to keep the bus busy.
+ ***************************************************/
+
+#ifndef ROBOEYES_STRIPFLUSH_H
+#define ROBOEYES_STRIPFLUSH_H
+
+#include <Arduino.h>
+#include "RoboEyesCanvas.h"
+#include "RoboEyesSpans.h"
+#include "RoboEyesDma.h"
+
+// Pixels per strip buffer (two are allocated): 32 rows of a 320 px screen
+#ifndef ROBOEYES_STRIP_PIXELS
+#define ROBOEYES_STRIP_PIXELS (320 * 32)
+#endif
+
+class RoboEyesStripFlush {
+public:
+  // spans is shared with the direct path (only one of them draws at a time)
+  RoboEyesStripFlush(int16_t screenW, int16_t screenH, EyeSpanRasterizer &spans)
+    : _dma(NULL), _spans(spans), _list(NULL), _bg(0), _region(0), _nextY(0), _sending(-1), _queued(-1), _sent(false) {
+    for (uint8_t i = 0; i < 2; i++) {
+      _strip[i] = new RoboEyesCanvas(screenW, screenH);
+      _state[i] = STRIP_FREE;
+    }
+  }
+
+  ~RoboEyesStripFlush() {
+    wait();
+    for (uint8_t i = 0; i < 2; i++) delete _strip[i];
+  }
+
+  // Both buffers come from DMA-capable RAM; false if they can't be had
+  bool begin(RoboEyesDma *dma, uint32_t stripPixels) {
+    _dma = dma;
+    _dma->onDone(onDmaDone, this);
+    return _strip[0]->reserve(stripPixels, true) && _strip[1]->reserve(stripPixels, true);
+  }
+
+  // Queue a frame. The regions are copied; list must stay unchanged until idle().
+  void start(const EyeDrawList &list, const DirtyRegions &regions, uint16_t bg) {
+    wait();
+    _list = &list;
+    _regions = regions;
+    _bg = bg;
+    _region = 0;
+    _nextY = _regions.count() ? _regions[0].y : 0;
+    pump();
+  }
+
+  // Render strips into free buffers and keep the DMA fed. Never waits.
+  void pump() {
+    _dma->poll();
+    reap();
+    int8_t slot;
+    while ((slot = freeStrip()) >= 0 && renderNext(*_strip[slot])) {
+      _state[slot] = STRIP_READY;
+      if (_sending < 0) send(slot);
+      else _queued = slot;
+    }
+  }
+
+  // Nothing left to render or send (a finished transfer counts once pumped)
+  bool idle() const { return _sending < 0 && _queued < 0 && !_list; }
+
+  // Finish the current frame, blocking on the DMA where needed
+  void wait() {
+    while (!idle()) {
+      pump();
+      if (_sending >= 0 && !_sent) _dma->wait();
+    }
+  }
+
+private:
+  enum { STRIP_FREE, STRIP_READY, STRIP_SENDING };
+
+  int8_t freeStrip() const {
+    for (uint8_t i = 0; i < 2; i++) {
+      if (_state[i] == STRIP_FREE) return i;
+    }
+    return -1;
+  }
+
+  // Next strip of the current frame into canvas; false when the frame is done
+  bool renderNext(RoboEyesCanvas &canvas) {
+    if (!_list) return false;
+    while (_region < _regions.count()) {
+      const DirtyRect &r = _regions[_region];
+      int16_t bottom = r.y + r.h;
+      if (_nextY >= bottom || r.w <= 0) {
+        if (++_region < _regions.count()) _nextY = _regions[_region].y;
+        continue;
+      }
+      uint32_t rows = canvas.capacity() / r.w;
+      if (rows == 0) {
+        // Wider than a whole buffer (can't happen for strips >= screen width)
+        _nextY = bottom;
+        continue;
+      }
+      if (rows > (uint32_t)(bottom - _nextY)) rows = bottom - _nextY;
+      DirtyRect strip = { r.x, _nextY, r.w, (int16_t)rows };
+      canvas.setViewport(strip.x, strip.y, strip.w, strip.h);
+      GfxSpanSink<RoboEyesCanvas> sink(canvas);
+      _spans.render(*_list, strip, _bg, sink);
+      _nextY += strip.h;
+      return true;
+    }
+    _list = NULL;
+    return false;
+  }
+
+  // Only task context touches the slots: _sent is set by the callback and
+  // cleared here, and nothing is started while it is set
+  void reap() {
+    if (_sent) {
+      _state[_sending] = STRIP_FREE;
+      _sending = -1;
+      _sent = false;
+    }
+    if (_sending < 0 && _queued >= 0) {
+      int8_t next = _queued;
+      _queued = -1;
+      send(next);
+    }
+  }
+
+  void send(int8_t slot) {
+    RoboEyesCanvas &c = *_strip[slot];
+    _state[slot] = STRIP_SENDING;
+    _sending = slot;
+    _dma->start(c.viewportX(), c.viewportY(), c.viewportW(), c.viewportH(), c.getBuffer());
+  }
+
+  // Transfer done (possibly in an ISR): leave the rest to reap()
+  static void onDmaDone(void *ctx) {
+    ((RoboEyesStripFlush *)ctx)->_sent = true;
+  }
+
+  RoboEyesDma *_dma;
+  RoboEyesCanvas *_strip[2];
+  uint8_t _state[2];
+  EyeSpanRasterizer &_spans;
+  const EyeDrawList *_list;
+  DirtyRegions _regions;
+  uint16_t _bg;
+  uint8_t _region;
+  int16_t _nextY;
+  int8_t _sending;
+  int8_t _queued;
+  volatile bool _sent;
+};
+
+#endif // ROBOEYES_STRIPFLUSH_H
@@ -0,0 +1,176 @@
+/***************************************************
+ * RoboEyesTask.h - Optional render task for RoboEyes
+ * begin() moves eyes.update() onto a task of its own,
+ * pinned to one ESP32 core (a std::thread on the
+ * host). The other core only post()s EyeCommands
+ * (mood, position, blink, ...) through a lock-free
+ * queue; the render task applies them between frames.
+ * A slow network call then never stalls the eyes, and
+ * a slow frame never stalls the network. Without
+ * begin(), poll() from loop() does the same inline.
+ ***************************************************/
+
+#ifndef ROBOEYES_TASK_H
+#define ROBOEYES_TASK_H
+
+#include <Arduino.h>
+#include "RoboEyesQueue.h"
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif !defined(ARDUINO)
+#include <thread>
+#include <chrono>
+#endif
+
+// Core for the render task; the Arduino loop() and its network code run on core 1
+#ifndef ROBOEYES_RENDER_CORE
+#define ROBOEYES_RENDER_CORE 0
+#endif
+
+#ifndef ROBOEYES_RENDER_STACK
+#define ROBOEYES_RENDER_STACK 4096
+#endif
+
+// Commands that can wait for the render task (power of two)
+#ifndef ROBOEYES_COMMAND_QUEUE
+#define ROBOEYES_COMMAND_QUEUE 32
+#endif
+
+enum {
+  EYE_CMD_MOOD,         // a = mood
+  EYE_CMD_POSITION,     // a = position
+  EYE_CMD_BLINK,        // a = left eye, b = right eye
+  EYE_CMD_OPEN,         // a = left eye, b = right eye
+  EYE_CMD_CLOSE,        // a = left eye, b = right eye
+  EYE_CMD_CONFUSED,
+  EYE_CMD_LAUGH,
+  EYE_CMD_CURIOSITY,    // a = on
+  EYE_CMD_CYCLOPS,      // a = on
+  EYE_CMD_SWEAT,        // a = on
+  EYE_CMD_AUTOBLINKER,  // a = on, b = interval (s), value = variation (s)
+  EYE_CMD_IDLE,         // a = on, b = interval (s), value = variation (s)
+  EYE_CMD_PAUSE,        // stop drawing: the screen is lent to something else
+  EYE_CMD_RESUME,
+  EYE_CMD_STATS,        // print the frame profile to Serial; a = reset it afterwards
+  EYE_CMD_USER = 0x80   // from here on handed to the command hook
+};
+
+struct EyeCommand {
+  uint8_t type;
+  uint8_t a, b;
+  uint16_t value;
+};
+
+template<typename Eyes>
+class RoboEyesTask {
+public:
+  // Runs on the render task for EYE_CMD_USER and above
+  typedef void (*CommandHook)(Eyes &eyes, const EyeCommand &cmd);
+
+  explicit RoboEyesTask(Eyes &eyes) : _eyes(eyes), _hook(NULL), _paused(false), _running(false), _stop(false) {}
+  ~RoboEyesTask() { end(); }
+
+  void setCommandHook(CommandHook hook) { _hook = hook; }
+
+  // From one producer task only; false if the queue is full
+  bool post(const EyeCommand &cmd) { return _queue.push(cmd); }
+  bool post(uint8_t type, uint8_t a = 0, uint8_t b = 0, uint16_t value = 0) {
+    EyeCommand cmd = { type, a, b, value };
+    return post(cmd);
+  }
+
+  // Render side: applies what was posted, then lets the eyes draw a frame
+  void poll() {
+    EyeCommand cmd;
+    while (_queue.pop(cmd)) apply(cmd);
+    if (!_paused) _eyes.update();
+  }
+
+  // Starts the render task. From then on only the task may touch the eyes
+  // and the display. False if no task could be started: poll() from loop().
+  bool begin(uint8_t core = ROBOEYES_RENDER_CORE, uint8_t priority = 1) {
+    if (_running) return true;
+    _stop.store(false);
+#if defined(ESP32)
+    _running.store(xTaskCreatePinnedToCore(taskMain, "RoboEyes", ROBOEYES_RENDER_STACK, this,
+                                           priority, NULL, core) == pdPASS);
+#elif !defined(ARDUINO)
+    (void)core;
+    (void)priority;
+    _running.store(true);
+    _thread = std::thread(taskMain, this);
+#endif
+    return _running.load();
+  }
+
+  // Stops the render task after its current frame
+  void end() {
+    if (!_running) return;
+    _stop.store(true);
+#if defined(ESP32)
+    while (_running.load()) vTaskDelay(1);
+#elif !defined(ARDUINO)
+    _thread.join();
+#endif
+  }
+
+  bool running() const { return _running.load(); }
+
+private:
+  void apply(const EyeCommand &c) {
+    switch (c.type) {
+      case EYE_CMD_MOOD:        _eyes.setMood(c.a); break;
+      case EYE_CMD_POSITION:    _eyes.setPosition(c.a); break;
+      case EYE_CMD_BLINK:       _eyes.blink(c.a, c.b); break;
+      case EYE_CMD_OPEN:        _eyes.open(c.a, c.b); break;
+      case EYE_CMD_CLOSE:       _eyes.close(c.a, c.b); break;
+      case EYE_CMD_CONFUSED:    _eyes.anim_confused(); break;
+      case EYE_CMD_LAUGH:       _eyes.anim_laugh(); break;
+      case EYE_CMD_CURIOSITY:   _eyes.setCuriosity(c.a); break;
+      case EYE_CMD_CYCLOPS:     _eyes.setCyclops(c.a); break;
+      case EYE_CMD_SWEAT:       _eyes.setSweat(c.a); break;
+      case EYE_CMD_AUTOBLINKER: _eyes.setAutoblinker(c.a, c.b, c.value); break;
+      case EYE_CMD_IDLE:        _eyes.setIdleMode(c.a, c.b, c.value); break;
+      case EYE_CMD_PAUSE:       _paused = true; break;
+      case EYE_CMD_RESUME:      _paused = false; break;
+      case EYE_CMD_STATS:
+        _eyes.dumpStats(Serial);
+        if (c.a) _eyes.resetStats();
+        break;
+      default:
+        if (c.type >= EYE_CMD_USER && _hook) _hook(_eyes, c);
+        break;
+    }
+  }
+
+  static void taskMain(void *arg) {
+    RoboEyesTask *self = (RoboEyesTask *)arg;
+    while (!self->_stop.load()) {
+      self->poll();
+      // update() keeps its own frame rate; sleeping a tick feeds the idle task
+#if defined(ESP32)
+      vTaskDelay(1);
+#elif !defined(ARDUINO)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+    self->_running.store(false);
+#if defined(ESP32)
+    vTaskDelete(NULL);
+#endif
+  }
+
+  Eyes &_eyes;
+  CommandHook _hook;
+  EyeSpscQueue<EyeCommand, ROBOEYES_COMMAND_QUEUE> _queue;
+  bool _paused;                 // render side only
+  std::atomic<bool> _running;
+  std::atomic<bool> _stop;
+#if !defined(ESP32) && !defined(ARDUINO)
+  std::thread _thread;
+#endif
+};
+
+#endif // ROBOEYES_TASK_H
@@ -0,0 +1,54 @@
+/***************************************************
+ * RoboEyesTimers.h - Behaviour timers in one place
+ * Blink, idle, laugh, confused, saccade and mood
+ * transition deadlines live in one small table instead
+ * of a timestamp each, polled with its own millis().
+ * Everything compares wrap-safe against one "now", and
+ * next() tells the earliest deadline, so a face at rest
+ * can let the sketch sleep until then.
+ ***************************************************/
+
+#ifndef ROBOEYES_TIMERS_H
+#define ROBOEYES_TIMERS_H
+
+#include <Arduino.h>
+
+template<uint8_t N>
+class EyeTimers {
+public:
+  EyeTimers() : _armed(0) { memset(_at, 0, sizeof(_at)); }
+
+  void arm(uint8_t id, unsigned long at) {
+    _at[id] = at;
+    _armed |= 1UL << id;
+  }
+  void disarm(uint8_t id) { _armed &= ~(1UL << id); }
+
+  bool armed(uint8_t id) const { return _armed & (1UL << id); }
+  unsigned long at(uint8_t id) const { return _at[id]; }
+
+  // Armed and reached
+  bool due(uint8_t id, unsigned long now) const {
+    return armed(id) && (long)(now - _at[id]) >= 0;
+  }
+
+  // Earliest deadline among the armed timers in mask (bit per id), relative
+  // to now so it survives millis() wrapping. False, and at = now, if none
+  // is armed.
+  bool next(uint32_t mask, unsigned long now, unsigned long &at) const {
+    bool found = false;
+    at = now;
+    for (uint8_t id = 0; id < N; id++) {
+      if (!(mask & _armed & (1UL << id))) continue;
+      if (!found || (long)(_at[id] - now) < (long)(at - now)) at = _at[id];
+      found = true;
+    }
+    return found;
+  }
+
+private:
+  unsigned long _at[N];
+  uint32_t _armed;
+};
+
+#endif // ROBOEYES_TIMERS_H
@@ -0,0 +1,211 @@
+/***************************************************
+ * RoboEyesTimeline.h - Non-blocking keyframe clips
+ * A clip is a set of tracks, each a list of keyframes
+ * for one parameter, all kept in PROGMEM. play()
+ * starts a clip and returns at once; update() moves
+ * every playing clip to the given time and sums their
+ * tracks, so the values are offsets layered on top of
+ * the base eye state. queue() holds a clip back until
+ * everything before it has finished.
+ ***************************************************/
+
+#ifndef ROBOEYES_TIMELINE_H
+#define ROBOEYES_TIMELINE_H
+
+#include <Arduino.h>
+
+// Clips that can play at the same time
+#ifndef EYE_TIMELINE_LAYERS
+#define EYE_TIMELINE_LAYERS 4
+#endif
+
+// Clips that can wait in the queue
+#ifndef EYE_TIMELINE_QUEUE
+#define EYE_TIMELINE_QUEUE 8
+#endif
+
+// How a track moves into a keyframe from the one before it
+enum {
+  EASE_STEP,     // holds the previous value, jumps at the keyframe
+  EASE_LINEAR,
+  EASE_IN,       // quadratic, slow start
+  EASE_OUT,      // quadratic, slow end
+  EASE_IN_OUT    // smoothstep
+};
+
+struct EyeKeyframe {
+  uint16_t t;    // ms from the start of the clip
+  int16_t value;
+  uint8_t ease;  // EASE_* into this keyframe
+};
+
+// Before its first keyframe a track eases in from 0; after its last one it holds
+struct EyeTrack {
+  uint8_t param;
+  uint8_t keyCount;
+  const EyeKeyframe *keys;
+};
+
+struct EyeClip {
+  uint16_t duration;  // ms per loop, > 0
+  uint8_t repeat;     // extra loops after the first
+  uint8_t trackCount;
+  const EyeTrack *tracks;
+};
+
+#define EYE_TRACK(param, keys) { param, sizeof(keys) / sizeof(keys[0]), keys }
+#define EYE_CLIP(duration, repeat, tracks) { duration, repeat, sizeof(tracks) / sizeof(tracks[0]), tracks }
+#define EYE_PAUSE(duration) { duration, 0, 0, NULL }
+
+template<uint8_t PARAMS>
+class EyeTimeline {
+public:
+  EyeTimeline() : _lateBy(0) {
+    stop();
+    memset(_values, 0, sizeof(_values));
+  }
+
+  // Starts clip at now on top of whatever is playing; false if all layers
+  // are busy or the clip has no duration
+  bool play(const EyeClip *clip, unsigned long now) {
+    if (!playable(clip)) return false;
+    for (uint8_t i = 0; i < EYE_TIMELINE_LAYERS; i++) {
+      if (!_layers[i].clip) {
+        _layers[i].clip = clip;
+        _layers[i].start = now;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Starts clip once nothing is playing and the clips queued before it are
+  // done; false if the queue is full or the clip has no duration
+  bool queue(const EyeClip *clip) {
+    if (!playable(clip)) return false;
+    if (_queued == EYE_TIMELINE_QUEUE) return false;
+    _queue[(_queueHead + _queued) % EYE_TIMELINE_QUEUE] = clip;
+    _queued++;
+    return true;
+  }
+
+  // Drops every clip; values go back to 0 on the next update()
+  void stop() {
+    memset(_layers, 0, sizeof(_layers));
+    _queueHead = 0;
+    _queued = 0;
+  }
+
+  bool active() const {
+    if (_queued) return true;
+    for (uint8_t i = 0; i < EYE_TIMELINE_LAYERS; i++) {
+      if (_layers[i].clip) return true;
+    }
+    return false;
+  }
+
+  // Moves every clip to now; true if any value changed
+  bool update(unsigned long now) {
+    bool playing = retire(now);
+    // A queued clip starts where the last one ended, so chains keep their timing
+    while (!playing && _queued) {
+      play(_queue[_queueHead], now - _lateBy);
+      _queueHead = (_queueHead + 1) % EYE_TIMELINE_QUEUE;
+      _queued--;
+      playing = retire(now);
+    }
+
+    int16_t values[PARAMS];
+    memset(values, 0, sizeof(values));
+    for (uint8_t i = 0; i < EYE_TIMELINE_LAYERS; i++) {
+      const EyeClip *clip = _layers[i].clip;
+      if (!clip) continue;
+      EyeClip c;
+      memcpy_P(&c, clip, sizeof(c));
+      uint16_t t = (now - _layers[i].start) % c.duration;
+      for (uint8_t k = 0; k < c.trackCount; k++) {
+        EyeTrack track;
+        memcpy_P(&track, &c.tracks[k], sizeof(track));
+        if (track.param < PARAMS) values[track.param] += sample(track, t);
+      }
+    }
+
+    bool changed = memcmp(values, _values, sizeof(values)) != 0;
+    memcpy(_values, values, sizeof(values));
+    return changed;
+  }
+
+  // Sum of every playing track for param as of the last update()
+  int16_t value(uint8_t param) const { return _values[param]; }
+
+private:
+  struct Layer {
+    const EyeClip *clip;
+    unsigned long start;
+  };
+
+  // Frees the layers whose clip has run out; true if any is still playing.
+  // _lateBy is how long ago the most recent of them ended (0 if none did).
+  bool retire(unsigned long now) {
+    bool playing = false;
+    _lateBy = 0;
+    bool retired = false;
+    for (uint8_t i = 0; i < EYE_TIMELINE_LAYERS; i++) {
+      const EyeClip *clip = _layers[i].clip;
+      if (!clip) continue;
+      EyeClip c;
+      memcpy_P(&c, clip, sizeof(c));
+      unsigned long length = (unsigned long)c.duration * (c.repeat + 1);
+      unsigned long elapsed = now - _layers[i].start;
+      if (elapsed < length) {
+        playing = true;
+        continue;
+      }
+      unsigned long late = elapsed - length;
+      if (!retired || late < _lateBy) _lateBy = late;
+      retired = true;
+      _layers[i].clip = NULL;
+    }
+    return playing;
+  }
+
+  // A clip of 0 ms would never end, nor could update() find where it is
+  static bool playable(const EyeClip *clip) {
+    if (!clip) return false;
+    EyeClip c;
+    memcpy_P(&c, clip, sizeof(c));
+    return c.duration > 0;
+  }
+
+  static int16_t sample(const EyeTrack &track, uint16_t t) {
+    EyeKeyframe a = { 0, 0, EASE_STEP };
+    EyeKeyframe b;
+    for (uint8_t k = 0; k < track.keyCount; k++) {
+      memcpy_P(&b, &track.keys[k], sizeof(b));
+      if (t < b.t) return interpolate(a, b, t);
+      a = b;
+    }
+    return a.value;
+  }
+
+  // a.t <= t < b.t; progress and easing in Q10
+  static int16_t interpolate(const EyeKeyframe &a, const EyeKeyframe &b, uint16_t t) {
+    if (b.ease == EASE_STEP) return a.value;
+    uint32_t p = ((uint32_t)(t - a.t) << 10) / (uint16_t)(b.t - a.t);
+    switch (b.ease) {
+      case EASE_IN:     p = (p * p) >> 10; break;
+      case EASE_OUT:    p = 1024 - (((1024 - p) * (1024 - p)) >> 10); break;
+      case EASE_IN_OUT: p = (((p * p) >> 10) * (3072 - 2 * p)) >> 10; break;
+    }
+    return a.value + (int16_t)(((int32_t)(b.value - a.value) * (int32_t)p) / 1024);
+  }
+
+  Layer _layers[EYE_TIMELINE_LAYERS];
+  const EyeClip *_queue[EYE_TIMELINE_QUEUE];
+  uint8_t _queueHead;
+  uint8_t _queued;
+  unsigned long _lateBy;
+  int16_t _values[PARAMS];
+};
+
+#endif // ROBOEYES_TIMELINE_H
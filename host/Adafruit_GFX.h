@@ -0,0 +1,90 @@
+/***************************************************
+ * Adafruit_GFX.h - Host stand-in for Adafruit GFX
+ * Same primitive algorithms as the real library so
+ * pixels (and the low-level calls they turn into)
+ * match what the ESP32 sends to the panel. Every
+ * top-level primitive call is counted per object.
+ ***************************************************/
+
+#ifndef HOST_ADAFRUIT_GFX_H
+#define HOST_ADAFRUIT_GFX_H
+
+#include "Arduino.h"
+
+// Primitive kinds counted by the host harness
+enum GfxPrimitive {
+  GFX_PRIM_DRAW_PIXEL,
+  GFX_PRIM_FAST_HLINE,
+  GFX_PRIM_FAST_VLINE,
+  GFX_PRIM_FILL_RECT,
+  GFX_PRIM_FILL_SCREEN,
+  GFX_PRIM_DRAW_LINE,
+  GFX_PRIM_DRAW_RECT,
+  GFX_PRIM_FILL_CIRCLE,
+  GFX_PRIM_FILL_ROUND_RECT,
+  GFX_PRIM_FILL_TRIANGLE,
+  GFX_PRIM_DRAW_RGB_BITMAP,
+  // write*() called directly between startWrite()/endWrite()
+  GFX_PRIM_WRITE_PIXEL,
+  GFX_PRIM_WRITE_FILL_RECT,
+  GFX_PRIM_WRITE_FAST_HLINE,
+  GFX_PRIM_WRITE_FAST_VLINE,
+  GFX_PRIM_COUNT
+};
+
+class Adafruit_GFX {
+public:
+  Adafruit_GFX(int16_t w, int16_t h);
+  virtual ~Adafruit_GFX() {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+  virtual void startWrite(void) {}
+  virtual void writePixel(int16_t x, int16_t y, uint16_t color);
+  virtual void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  virtual void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  virtual void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  virtual void endWrite(void) {}
+
+  virtual void setRotation(uint8_t r);
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  virtual void fillScreen(uint16_t color);
+  virtual void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+  virtual void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  void fillCircle(int16_t x0, int16_t y0, int16_t r, uint16_t color);
+  void fillCircleHelper(int16_t x0, int16_t y0, int16_t r, uint8_t corners, int16_t delta, uint16_t color);
+  void fillRoundRect(int16_t x0, int16_t y0, int16_t w, int16_t h, int16_t radius, uint16_t color);
+  void fillTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t *bitmap, int16_t w, int16_t h);
+
+  int16_t width(void) const { return _width; }
+  int16_t height(void) const { return _height; }
+  uint8_t getRotation(void) const { return rotation; }
+
+  // ---- Host instrumentation (not part of the real library) ----
+  unsigned long hostPrimitiveCalls(GfxPrimitive p) const { return _calls[p]; }
+  unsigned long hostPrimitiveCalls() const;
+  void hostResetPrimitiveCalls();
+
+protected:
+  // Counts only the outermost call; nested primitives are implementation detail
+  struct CallScope {
+    CallScope(Adafruit_GFX *g, GfxPrimitive p) : gfx(g) { if (gfx->_depth++ == 0) gfx->_calls[p]++; }
+    ~CallScope() { gfx->_depth--; }
+    Adafruit_GFX *gfx;
+  };
+
+  const int16_t WIDTH, HEIGHT;
+  int16_t _width, _height;
+  uint8_t rotation;
+
+private:
+  unsigned long _calls[GFX_PRIM_COUNT];
+  uint8_t _depth;
+};
+
+#endif // HOST_ADAFRUIT_GFX_H
@@ -0,0 +1,296 @@
+/***************************************************
+ * Adafruit_SPITFT.cpp - Host stand-in implementation
+ * Clipping follows Adafruit-GFX-Library's SPITFT class.
+ ***************************************************/
+
+#include "Adafruit_SPITFT.h"
+
+SPIClass SPI;
+
+Adafruit_SPITFT::Adafruit_SPITFT(uint16_t w, uint16_t h)
+  : Adafruit_GFX(w, h), _panelW(0), _panelH(0), _gram(NULL), _pixelBits(16), _writeDepth(0),
+    _lastCommand(0), _ramwr(false), _casX0(0), _casX1(w - 1), _rasY0(0), _rasY1(h - 1),
+    _nibbles(0), _nibbleCount(0),
+    _winX(0), _winY(0), _winW(0), _winH(0), _curX(0), _curY(0) {
+  hostSetPanelSize(w, h);
+  hostResetStats();
+}
+
+Adafruit_SPITFT::~Adafruit_SPITFT() {
+  free(_gram);
+}
+
+void Adafruit_SPITFT::hostSetPanelSize(uint16_t w, uint16_t h) {
+  free(_gram);
+  _panelW = w;
+  _panelH = h;
+  _gram = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+}
+
+void Adafruit_SPITFT::hostResetStats() {
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+void Adafruit_SPITFT::startWrite(void) {
+  if (_writeDepth++ == 0) _stats.transactions++;
+}
+
+void Adafruit_SPITFT::endWrite(void) {
+  if (_writeDepth) _writeDepth--;
+}
+
+// Logical (rotated) coordinates to panel GRAM coordinates, laid out the way
+// Adafruit_ST7789's MADCTL per rotation puts them in frame memory (rotation 2
+// is the panel's own order). Only matters for what scrolls with GRAM rows.
+void Adafruit_SPITFT::hostMapToPanel(int16_t x, int16_t y, int16_t &px, int16_t &py) const {
+  switch (rotation) {
+    case 0:  px = _panelW - 1 - x; py = _panelH - 1 - y; break;  // MX | MY
+    case 1:  px = y; py = _panelH - 1 - x; break;                // MY | MV
+    case 3:  px = _panelW - 1 - y; py = x; break;                // MX | MV
+    default: px = x; py = y; break;
+  }
+}
+
+void Adafruit_SPITFT::hostBeginWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  _winX = _curX = x;
+  _winY = _curY = y;
+  _winW = w;
+  _winH = h;
+  _nibbles = 0;
+  _nibbleCount = 0;  // RAMWR starts a new pixel
+  _ramwr = true;
+  _stats.addrWindows++;
+}
+
+void Adafruit_SPITFT::writeCommand(uint8_t cmd) {
+  _stats.spiBytes++;
+  _lastCommand = cmd;
+  _ramwr = false;
+  if (cmd == 0x2C) hostBeginWindow(_casX0, _rasY0, _casX1 - _casX0 + 1, _rasY1 - _rasY0 + 1);  // RAMWR
+}
+
+void Adafruit_SPITFT::SPI_WRITE32(uint32_t l) {
+  _stats.spiBytes += 4;
+  if (_lastCommand == 0x2A) {         // CASET: first and last column
+    _casX0 = l >> 16;
+    _casX1 = l & 0xFFFF;
+  } else if (_lastCommand == 0x2B) {  // RASET: first and last row
+    _rasY0 = l >> 16;
+    _rasY1 = l & 0xFFFF;
+  }
+}
+
+void Adafruit_SPITFT::hostPushPixel(uint16_t color) {
+  _stats.spiBytes += 2;
+  if (!_ramwr) {
+    _stats.dropped++;
+    return;
+  }
+  if (_pixelBits != 12) {
+    hostStorePixel(color);
+    return;
+  }
+  // RGB444: every three nibbles are a pixel, shown as the RGB565 it expands to
+  for (int8_t shift = 12; shift >= 0; shift -= 4) {
+    _nibbles = (_nibbles << 4) | ((color >> shift) & 0x0F);
+    if (++_nibbleCount < 3) continue;
+    uint16_t r = (_nibbles >> 8) & 0x0F, g = (_nibbles >> 4) & 0x0F, b = _nibbles & 0x0F;
+    hostStorePixel(((r << 1 | r >> 3) << 11) | ((g << 2 | g >> 2) << 5) | (b << 1 | b >> 3));
+    _nibbles = 0;
+    _nibbleCount = 0;
+  }
+}
+
+void Adafruit_SPITFT::hostStorePixel(uint16_t color) {
+  _stats.pixels++;
+  if (_curX >= 0 && _curX < _width && _curY >= 0 && _curY < _height) {
+    int16_t px, py;
+    hostMapToPanel(_curX, _curY, px, py);
+    _gram[(int32_t)py * _panelW + px] = color;
+  }
+  if (++_curX >= _winX + _winW) {
+    _curX = _winX;
+    if (++_curY >= _winY + _winH) _curY = _winY;
+  }
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block, bool bigEndian) {
+  (void)block;
+  while (len--) {
+    uint16_t c = *colors++;
+    if (bigEndian) c = (uint16_t)((c >> 8) | (c << 8));
+    hostPushPixel(c);
+  }
+}
+
+void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
+  while (len--) hostPushPixel(color);
+}
+
+void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_WRITE_PIXEL);
+  if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    setAddrWindow(x, y, 1, 1);
+    hostPushPixel(color);
+  }
+}
+
+void Adafruit_SPITFT::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h,
+                                              uint16_t color) {
+  setAddrWindow(x, y, w, h);
+  writeColor(color, (uint32_t)w * h);
+}
+
+void Adafruit_SPITFT::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_WRITE_FILL_RECT);
+  if (w && h) {
+    if (w < 0) { x += w + 1; w = -w; }
+    if (x < _width) {
+      if (h < 0) { y += h + 1; h = -h; }
+      if (y < _height) {
+        int16_t x2 = x + w - 1;
+        if (x2 >= 0) {
+          int16_t y2 = y + h - 1;
+          if (y2 >= 0) {
+            if (x < 0) { x = 0; w = x2 + 1; }
+            if (y < 0) { y = 0; h = y2 + 1; }
+            if (x2 >= _width) w = _width - x;
+            if (y2 >= _height) h = _height - y;
+            writeFillRectPreclipped(x, y, w, h, color);
+          }
+        }
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_WRITE_FAST_HLINE);
+  if ((y >= 0) && (y < _height) && w) {
+    if (w < 0) { x += w + 1; w = -w; }
+    if (x < _width) {
+      int16_t x2 = x + w - 1;
+      if (x2 >= 0) {
+        if (x < 0) { x = 0; w = x2 + 1; }
+        if (x2 >= _width) w = _width - x;
+        writeFillRectPreclipped(x, y, w, 1, color);
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_WRITE_FAST_VLINE);
+  if ((x >= 0) && (x < _width) && h) {
+    if (h < 0) { y += h + 1; h = -h; }
+    if (y < _height) {
+      int16_t y2 = y + h - 1;
+      if (y2 >= 0) {
+        if (y < 0) { y = 0; h = y2 + 1; }
+        if (y2 >= _height) h = _height - y;
+        writeFillRectPreclipped(x, y, 1, h, color);
+      }
+    }
+  }
+}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_DRAW_PIXEL);
+  if ((x >= 0) && (x < _width) && (y >= 0) && (y < _height)) {
+    startWrite();
+    setAddrWindow(x, y, 1, 1);
+    hostPushPixel(color);
+    endWrite();
+  }
+}
+
+void Adafruit_SPITFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_FILL_RECT);
+  startWrite();
+  writeFillRect(x, y, w, h, color);
+  endWrite();
+}
+
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_FAST_HLINE);
+  startWrite();
+  writeFastHLine(x, y, w, color);
+  endWrite();
+}
+
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  CallScope scope(this, GFX_PRIM_FAST_VLINE);
+  startWrite();
+  writeFastVLine(x, y, h, color);
+  endWrite();
+}
+
+void Adafruit_SPITFT::drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors, int16_t w,
+                                    int16_t h) {
+  CallScope scope(this, GFX_PRIM_DRAW_RGB_BITMAP);
+  int16_t x2, y2;
+  if ((x >= _width) || (y >= _height) || ((x2 = (x + w - 1)) < 0) || ((y2 = (y + h - 1)) < 0))
+    return;
+
+  int16_t bx1 = 0, by1 = 0, saveW = w;
+  if (x < 0) { w += x; bx1 = -x; x = 0; }
+  if (y < 0) { h += y; by1 = -y; y = 0; }
+  if (x2 >= _width) w = _width - x;
+  if (y2 >= _height) h = _height - y;
+
+  pcolors += by1 * saveW + bx1;
+  startWrite();
+  setAddrWindow(x, y, w, h);
+  while (h--) {
+    writePixels(pcolors, w);
+    pcolors += saveW;
+  }
+  endWrite();
+}
+
+void Adafruit_SPITFT::sendCommand(uint8_t commandByte, const uint8_t *dataBytes,
+                                  uint8_t numDataBytes) {
+  _stats.commands++;
+  _stats.spiBytes += 1 + numDataBytes;
+  _ramwr = false;
+  hostCommand(commandByte, dataBytes, numDataBytes);
+}
+
+uint16_t Adafruit_SPITFT::hostPixel(int16_t x, int16_t y) const {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) return 0;
+  int16_t px, py;
+  hostMapToPanel(x, y, px, py);
+  return _gram[(int32_t)hostShownRow(py) * _panelW + px];
+}
+
+uint32_t Adafruit_SPITFT::hostFrameChecksum() const {
+  // FNV-1a over the visible frame in logical order
+  uint32_t h = 2166136261UL;
+  for (int16_t y = 0; y < _height; y++) {
+    for (int16_t x = 0; x < _width; x++) {
+      uint16_t c = hostPixel(x, y);
+      h = (h ^ (c & 0xFF)) * 16777619UL;
+      h = (h ^ (c >> 8)) * 16777619UL;
+    }
+  }
+  return h;
+}
+
+bool Adafruit_SPITFT::hostWritePPM(const char *path) const {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P6\n%d %d\n255\n", _width, _height);
+  for (int16_t y = 0; y < _height; y++) {
+    for (int16_t x = 0; x < _width; x++) {
+      uint16_t c = hostPixel(x, y);
+      uint8_t rgb[3] = {
+        (uint8_t)(((c >> 11) & 0x1F) * 255 / 31),
+        (uint8_t)(((c >> 5) & 0x3F) * 255 / 63),
+        (uint8_t)((c & 0x1F) * 255 / 31)
+      };
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  fclose(f);
+  return true;
+}
@@ -0,0 +1,99 @@
+/***************************************************
+ * Adafruit_SPITFT.h - Host stand-in for the SPI TFT base
+ * Models the panel GRAM and what a real transfer costs:
+ * every setAddrWindow() is CASET+RASET+RAMWR (3 command
+ * bytes + 8 data bytes), every pixel is 2 bytes (1.5
+ * once COLMOD has put the panel in 12 bpp). The window
+ * takes effect at RAMWR, as on the panel, so drivers
+ * may send the three commands on their own; any other
+ * command ends the pixel stream, and pixel data after
+ * it is dropped until the next RAMWR.
+ ***************************************************/
+
+#ifndef HOST_ADAFRUIT_SPITFT_H
+#define HOST_ADAFRUIT_SPITFT_H
+
+#include "Adafruit_GFX.h"
+#include "SPI.h"
+
+// Bus traffic counters (host only)
+struct SPITFTHostStats {
+  unsigned long transactions; // outermost startWrite()/endWrite() pairs
+  unsigned long addrWindows;  // windows opened (RAMWR)
+  unsigned long commands;     // other commands (sendCommand)
+  unsigned long pixels;       // pixels clocked into GRAM
+  unsigned long dropped;      // pixel words sent with no RAMWR in effect
+  unsigned long spiBytes;     // estimated bytes on the wire
+};
+
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+  Adafruit_SPITFT(uint16_t w, uint16_t h);
+  ~Adafruit_SPITFT();
+
+  virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) = 0;
+
+  void startWrite(void) override;
+  void endWrite(void) override;
+  void writePixel(int16_t x, int16_t y, uint16_t color) override;
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true, bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+  void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void drawRGBBitmap(int16_t x, int16_t y, uint16_t *pcolors, int16_t w, int16_t h);
+  using Adafruit_GFX::drawRGBBitmap;
+
+  void sendCommand(uint8_t commandByte, const uint8_t *dataBytes = NULL, uint8_t numDataBytes = 0);
+  // A command byte and a 32-bit data word, inside startWrite()/endWrite()
+  void writeCommand(uint8_t cmd);
+  void SPI_WRITE32(uint32_t l);
+  void dmaWait(void) {}
+  bool dmaBusy(void) const { return false; }
+  uint16_t color565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+  }
+
+  // ---- Host instrumentation (not part of the real library) ----
+  const SPITFTHostStats &hostStats() const { return _stats; }
+  void hostResetStats();
+  uint16_t hostPixel(int16_t x, int16_t y) const;  // logical coords, as shown
+  uint32_t hostFrameChecksum() const;
+  bool hostWritePPM(const char *path) const;
+
+protected:
+  // Panel command hook so a driver can emulate what it understands
+  virtual void hostCommand(uint8_t cmd, const uint8_t *data, uint8_t n) { (void)cmd; (void)data; (void)n; }
+  // GRAM row the panel shows on its line row (a scrolling driver moves them)
+  virtual int16_t hostShownRow(int16_t row) const { return row; }
+  void hostSetPanelSize(uint16_t w, uint16_t h);
+  void hostMapToPanel(int16_t x, int16_t y, int16_t &px, int16_t &py) const;
+  // One 16-bit word of pixel data, high byte first on the wire
+  void hostPushPixel(uint16_t color);
+
+  uint16_t _panelW, _panelH;
+  uint16_t *_gram;
+  SPITFTHostStats _stats;
+  uint8_t _pixelBits;  // 16 (RGB565) or 12 (RGB444), as set by COLMOD
+
+private:
+  void hostStorePixel(uint16_t color);
+
+  void hostBeginWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+  uint8_t _writeDepth;
+  uint8_t _lastCommand;                  // writeCommand(), for the data after it
+  bool _ramwr;                           // pixel data goes to GRAM (RAMWR was the last command)
+  uint16_t _casX0, _casX1, _rasY0, _rasY1;  // CASET / RASET as last sent
+  uint16_t _nibbles;   // 12 bpp: nibbles of the pixel being assembled
+  uint8_t _nibbleCount;
+  int16_t _winX, _winY, _winW, _winH, _curX, _curY;
+};
+
+#endif // HOST_ADAFRUIT_SPITFT_H
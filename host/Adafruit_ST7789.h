@@ -0,0 +1,66 @@
+/***************************************************
+ * Adafruit_ST7789.h - Host stand-in for the ST7789 driver
+ * Records into an in-memory RGB565 GRAM instead of SPI,
+ * and shows it through the panel's vertical scrolling
+ * (VSCRDEF / VSCSAD) like the real controller does;
+ * COLMOD switches between 16 and 12 bits per pixel.
+ ***************************************************/
+
+#ifndef HOST_ADAFRUIT_ST7789_H
+#define HOST_ADAFRUIT_ST7789_H
+
+#include "Adafruit_ST77xx.h"
+
+class Adafruit_ST7789 : public Adafruit_ST77xx {
+public:
+  Adafruit_ST7789(int8_t cs, int8_t dc, int8_t rst)
+    : Adafruit_ST77xx(240, 320), _scrollTop(0), _scrollLines(320), _scrollStart(0) {
+    (void)cs; (void)dc; (void)rst;
+  }
+  Adafruit_ST7789(int8_t cs, int8_t dc, int8_t mosi, int8_t sclk, int8_t rst = -1)
+    : Adafruit_ST77xx(240, 320), _scrollTop(0), _scrollLines(320), _scrollStart(0) {
+    (void)cs; (void)dc; (void)mosi; (void)sclk; (void)rst;
+  }
+
+  void init(uint16_t width, uint16_t height, uint8_t spiMode = 0) {
+    (void)spiMode;
+    hostSetPanelSize(width, height);
+    _width = width;
+    _height = height;
+    // Reset state: the whole GRAM is one scroll area, unscrolled
+    _scrollTop = 0;
+    _scrollLines = height;
+    _scrollStart = 0;
+    _pixelBits = 16;
+    setRotation(0);
+  }
+
+  void setRotation(uint8_t m) override {
+    rotation = m & 3;
+    _width = (rotation & 1) ? _panelH : _panelW;
+    _height = (rotation & 1) ? _panelW : _panelH;
+  }
+
+protected:
+  void hostCommand(uint8_t cmd, const uint8_t *data, uint8_t n) override {
+    if (cmd == 0x33 && n == 6) {         // VSCRDEF: top fixed, scroll, bottom fixed lines
+      _scrollTop = (data[0] << 8) | data[1];
+      _scrollLines = (data[2] << 8) | data[3];
+    } else if (cmd == 0x37 && n == 2) {  // VSCSAD: GRAM row shown first in the scroll area
+      _scrollStart = (data[0] << 8) | data[1];
+    } else if (cmd == 0x3A && n == 1) {  // COLMOD: 0x55 RGB565, 0x53 RGB444
+      _pixelBits = ((data[0] & 0x07) == 3) ? 12 : 16;
+    }
+  }
+
+  int16_t hostShownRow(int16_t row) const override {
+    if (row < _scrollTop || row >= _scrollTop + _scrollLines || _scrollLines == 0) return row;
+    int32_t r = (int32_t)row - _scrollTop + _scrollStart - _scrollTop;
+    return _scrollTop + (int16_t)(((r % _scrollLines) + _scrollLines) % _scrollLines);
+  }
+
+private:
+  uint16_t _scrollTop, _scrollLines, _scrollStart;
+};
+
+#endif // HOST_ADAFRUIT_ST7789_H
@@ -0,0 +1,57 @@
+/***************************************************
+ * Adafruit_ST77xx.h - Host stand-in for the ST77xx family
+ ***************************************************/
+
+#ifndef HOST_ADAFRUIT_ST77XX_H
+#define HOST_ADAFRUIT_ST77XX_H
+
+#include "Adafruit_SPITFT.h"
+
+#define ST77XX_NOP 0x00
+#define ST77XX_SWRESET 0x01
+#define ST77XX_SLPIN 0x10
+#define ST77XX_SLPOUT 0x11
+#define ST77XX_NORON 0x13
+#define ST77XX_INVOFF 0x20
+#define ST77XX_INVON 0x21
+#define ST77XX_DISPOFF 0x28
+#define ST77XX_DISPON 0x29
+#define ST77XX_CASET 0x2A
+#define ST77XX_RASET 0x2B
+#define ST77XX_RAMWR 0x2C
+#define ST77XX_MADCTL 0x36
+#define ST77XX_COLMOD 0x3A
+
+// Some ready-made 16-bit ('565') color settings:
+#define ST77XX_BLACK 0x0000
+#define ST77XX_WHITE 0xFFFF
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_BLUE 0x001F
+#define ST77XX_CYAN 0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW 0xFFE0
+#define ST77XX_ORANGE 0xFC00
+
+class Adafruit_ST77xx : public Adafruit_SPITFT {
+public:
+  Adafruit_ST77xx(uint16_t w, uint16_t h) : Adafruit_SPITFT(w, h), _xstart(0), _ystart(0) {}
+
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override {
+    x += _xstart;
+    y += _ystart;
+    writeCommand(ST77XX_CASET);
+    SPI_WRITE32((uint32_t)x << 16 | (uint16_t)(x + w - 1));
+    writeCommand(ST77XX_RASET);
+    SPI_WRITE32((uint32_t)y << 16 | (uint16_t)(y + h - 1));
+    writeCommand(ST77XX_RAMWR);
+  }
+  void enableDisplay(bool) {}
+  void enableSleep(bool) {}
+  void enableTearing(bool) {}
+
+protected:
+  int16_t _xstart, _ystart;  // panel offset of the visible area (0 on 240x320)
+};
+
+#endif // HOST_ADAFRUIT_ST77XX_H
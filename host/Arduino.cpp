@@ -0,0 +1,56 @@
+/***************************************************
+ * Arduino.cpp - Host stand-in implementation
+ ***************************************************/
+
+#include "Arduino.h"
+#include <stdarg.h>
+
+HostSerial Serial;
+
+static unsigned long hostMicros = 0;
+static uint32_t hostRandomState = 1;
+
+unsigned long millis() { return hostMicros / 1000UL; }
+unsigned long micros() { return hostMicros; }
+void delay(unsigned long ms) { hostMicros += ms * 1000UL; }
+void delayMicroseconds(unsigned int us) { hostMicros += us; }
+void yield() {}
+
+void hostSetMillis(unsigned long ms) { hostMicros = ms * 1000UL; }
+void hostAdvanceMillis(unsigned long ms) { hostMicros += ms * 1000UL; }
+
+// Same LCG as newlib's rand() so sequences are stable across hosts
+static uint32_t hostRand() {
+  hostRandomState = hostRandomState * 1103515245UL + 12345UL;
+  return (hostRandomState >> 16) & 0x7FFF;
+}
+
+long random(long howbig) {
+  if (howbig <= 0) return 0;
+  return (long)(((uint32_t)hostRand() << 15 | hostRand()) % (uint32_t)howbig);
+}
+
+long random(long howsmall, long howbig) {
+  if (howsmall >= howbig) return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed) {
+  if (seed != 0) hostRandomState = (uint32_t)seed;
+}
+
+void HostSerial::out(const char *fmt, ...) {
+  if (!echo) return;
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+}
+
+void HostSerial::printf(const char *fmt, ...) {
+  if (!echo) return;
+  va_list ap;
+  va_start(ap, fmt);
+  vfprintf(stderr, fmt, ap);
+  va_end(ap);
+}
@@ -0,0 +1,87 @@
+/***************************************************
+ * Arduino.h - Host (Linux) stand-in for the Arduino core
+ * Only what the RoboEyes / QR sources use. millis() and
+ * random() are deterministic so frames are reproducible.
+ ***************************************************/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+using std::min;
+using std::max;
+using std::abs;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+// Flash tables are plain memory here
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define memcpy_P memcpy
+
+#define HEX 16
+#define DEC 10
+
+// ========== Virtual clock ==========
+// millis()/micros() read a virtual clock that only moves when the host
+// harness advances it (or when the code under test calls delay()).
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void hostSetMillis(unsigned long ms);
+void hostAdvanceMillis(unsigned long ms);
+
+// ========== Deterministic random ==========
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+// ========== Serial ==========
+// Silent by default; Serial.echo = true mirrors output to stderr.
+class HostSerial {
+public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  void flush() {}
+
+  void print(const char *s) { out("%s", s); }
+  void print(char c) { out("%c", c); }
+  void print(int v, int base = DEC) { out(base == HEX ? "%x" : "%d", v); }
+  void print(unsigned int v, int base = DEC) { out(base == HEX ? "%x" : "%u", v); }
+  void print(long v, int base = DEC) { out(base == HEX ? "%lx" : "%ld", v); }
+  void print(unsigned long v, int base = DEC) { out(base == HEX ? "%lx" : "%lu", v); }
+  void print(double v, int digits = 2) { out("%.*f", digits, v); }
+
+  template<typename T> void println(T v) { print(v); out("\n"); }
+  template<typename T> void println(T v, int fmt) { print(v, fmt); out("\n"); }
+  void println() { out("\n"); }
+
+  void printf(const char *fmt, ...);
+
+  bool echo = false;
+
+private:
+  void out(const char *fmt, ...);
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
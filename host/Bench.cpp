@@ -0,0 +1,182 @@
+/***************************************************
+ * Bench.cpp - Frame benchmark / golden-frame harness
+ ***************************************************/
+
+#include "Bench.h"
+
+static const char *const primitiveNames[GFX_PRIM_COUNT] = {
+  "drawPixel", "drawFastHLine", "drawFastVLine", "fillRect", "fillScreen",
+  "drawLine", "drawRect", "fillCircle", "fillRoundRect", "fillTriangle",
+  "drawRGBBitmap", "writePixel", "writeFillRect", "writeFastHLine", "writeFastVLine"
+};
+
+static void usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [--only SCENARIO] [--frames] [--dump DIR]\n"
+          "          [--record FILE | --check FILE]\n", prog);
+}
+
+bool BenchOptions::parse(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(a, "--frames")) perFrame = true;
+    else if (!strcmp(a, "--only") && hasValue) only = argv[++i];
+    else if (!strcmp(a, "--dump") && hasValue) dumpDir = argv[++i];
+    else if (!strcmp(a, "--record") && hasValue) recordPath = argv[++i];
+    else if (!strcmp(a, "--check") && hasValue) checkPath = argv[++i];
+    else { usage(argv[0]); return false; }
+  }
+  return true;
+}
+
+Bench::Bench(const BenchOptions &opt)
+  : _opt(opt), _tft(NULL), _frameMs(33), _loopsPerFrame(1),
+    _wake(0), _wakeups(0), _frames(0), _needBaseline(true),
+    _totalFrames(0), _totalPixels(0), _totalSpiBytes(0),
+    _checkpoints(0), _mismatches(0), _missing(0), _record(NULL) {
+  memset(&_last, 0, sizeof(_last));
+  memset(&_sum, 0, sizeof(_sum));
+  memset(&_max, 0, sizeof(_max));
+  memset(_primBase, 0, sizeof(_primBase));
+  if (_opt.checkPath) loadGolden();
+  if (_opt.recordPath) {
+    _record = fopen(_opt.recordPath, "w");
+    if (!_record) fprintf(stderr, "bench: cannot write %s\n", _opt.recordPath);
+  }
+  printf("%-18s %6s %9s %8s %11s %10s %9s %9s\n", "scenario", "frames", "px/frame",
+         "max px", "prims/frame", "spiB/frame", "max spiB", "win/frame");
+}
+
+Bench::~Bench() {
+  if (_record) fclose(_record);
+}
+
+void Bench::loadGolden() {
+  FILE *f = fopen(_opt.checkPath, "r");
+  if (!f) {
+    fprintf(stderr, "bench: cannot read %s\n", _opt.checkPath);
+    return;
+  }
+  char key[128];
+  unsigned long hash;
+  while (fscanf(f, "%127s %lx", key, &hash) == 2) _golden[key] = (uint32_t)hash;
+  fclose(f);
+}
+
+bool Bench::start(const char *scenario, Adafruit_ST7789 &tft, uint16_t frameMs, uint16_t loopsPerFrame) {
+  if (_opt.only && strcmp(_opt.only, scenario)) return false;
+  _scenario = scenario;
+  _tft = &tft;
+  _frameMs = frameMs;
+  _loopsPerFrame = loopsPerFrame ? loopsPerFrame : 1;
+  _frames = 0;
+  _wake = 0;
+  _wakeups = 0;
+  memset(&_sum, 0, sizeof(_sum));
+  memset(&_max, 0, sizeof(_max));
+
+  hostSetMillis(0);
+  randomSeed(1);
+  tft.hostResetStats();
+  tft.hostResetPrimitiveCalls();
+
+  _needBaseline = true;
+  return true;
+}
+
+BenchSample Bench::snapshot() const {
+  BenchSample now;
+  const SPITFTHostStats &s = _tft->hostStats();
+  now.pixels = s.pixels;
+  now.primitives = _tft->hostPrimitiveCalls();
+  now.spiBytes = s.spiBytes;
+  now.addrWindows = s.addrWindows;
+  return now;
+}
+
+// Setup (begin(), the first fillScreen) is not part of the measured frames
+void Bench::baseline() {
+  _last = snapshot();
+  for (uint8_t p = 0; p < GFX_PRIM_COUNT; p++) _primBase[p] = _tft->hostPrimitiveCalls((GfxPrimitive)p);
+  _needBaseline = false;
+}
+
+void Bench::sample() {
+  BenchSample now = snapshot();
+  BenchSample d;
+  d.pixels = now.pixels - _last.pixels;
+  d.primitives = now.primitives - _last.primitives;
+  d.spiBytes = now.spiBytes - _last.spiBytes;
+  d.addrWindows = now.addrWindows - _last.addrWindows;
+  _last = now;
+
+  _sum.pixels += d.pixels;
+  _sum.primitives += d.primitives;
+  _sum.spiBytes += d.spiBytes;
+  _sum.addrWindows += d.addrWindows;
+  _max.pixels = max(_max.pixels, d.pixels);
+  _max.spiBytes = max(_max.spiBytes, d.spiBytes);
+  _frames++;
+
+  if (_opt.perFrame) {
+    printf("  %s #%lu t=%lu px=%lu prims=%lu spiB=%lu win=%lu\n", _scenario.c_str(), _frames,
+           millis(), d.pixels, d.primitives, d.spiBytes, d.addrWindows);
+  }
+}
+
+void Bench::checkpoint(const char *label) {
+  std::string key = _scenario + "/" + label;
+  uint32_t hash = _tft->hostFrameChecksum();
+  _checkpoints++;
+
+  if (_record) fprintf(_record, "%s %08lx\n", key.c_str(), (unsigned long)hash);
+
+  if (_opt.checkPath) {
+    std::map<std::string, uint32_t>::const_iterator it = _golden.find(key);
+    if (it == _golden.end()) {
+      printf("  MISSING  %s %08lx\n", key.c_str(), (unsigned long)hash);
+      _missing++;
+    } else if (it->second != hash) {
+      printf("  MISMATCH %s %08lx (golden %08lx)\n", key.c_str(), (unsigned long)hash,
+             (unsigned long)it->second);
+      _mismatches++;
+    }
+  }
+
+  if (_opt.dumpDir) {
+    std::string path = std::string(_opt.dumpDir) + "/" + _scenario + "-" + label + ".ppm";
+    if (!_tft->hostWritePPM(path.c_str())) fprintf(stderr, "bench: cannot write %s\n", path.c_str());
+  }
+}
+
+void Bench::finish() {
+  unsigned long n = _frames ? _frames : 1;
+  printf("%-18s %6lu %9lu %8lu %11.1f %10lu %9lu %9.1f\n", _scenario.c_str(), _frames,
+         _sum.pixels / n, _max.pixels, (double)_sum.primitives / n, _sum.spiBytes / n,
+         _max.spiBytes, (double)_sum.addrWindows / n);
+
+  printf("  calls:");
+  for (uint8_t p = 0; p < GFX_PRIM_COUNT; p++) {
+    unsigned long c = _tft->hostPrimitiveCalls((GfxPrimitive)p) - _primBase[p];
+    if (c) printf(" %s=%lu", primitiveNames[p], c);
+  }
+  printf("\n");
+  if (_wakeups) printf("  update() calls: %lu of %lu frames\n", _wakeups, _frames);
+
+  _totalFrames += _frames;
+  _totalPixels += _sum.pixels;
+  _totalSpiBytes += _sum.spiBytes;
+  _tft = NULL;
+}
+
+int Bench::report() {
+  unsigned long n = _totalFrames ? _totalFrames : 1;
+  printf("%-18s %6lu %9lu %8s %11s %10lu\n", "total", _totalFrames, _totalPixels / n, "", "",
+         _totalSpiBytes / n);
+  if (_opt.checkPath) {
+    printf("golden: %lu checkpoints, %lu mismatched, %lu missing\n", _checkpoints, _mismatches, _missing);
+    if (_mismatches || _missing || _golden.empty()) return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+/***************************************************
+ * Bench.h - Frame benchmark / golden-frame harness
+ * Drives an eyes object with the virtual clock, samples
+ * the stand-in display after every tick and reports
+ * pixels, primitive calls and SPI bytes per frame.
+ * Checkpoints hash the visible frame so they can be
+ * recorded once and checked on every later run.
+ ***************************************************/
+
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <Arduino.h>
+#include <Adafruit_ST7789.h>
+#include <map>
+#include <string>
+
+struct BenchOptions {
+  const char *dumpDir;    // write a PPM per checkpoint
+  const char *recordPath; // write checkpoint hashes
+  const char *checkPath;  // compare checkpoint hashes
+  const char *only;       // run a single scenario
+  bool perFrame;          // print one line per frame
+
+  BenchOptions() : dumpDir(NULL), recordPath(NULL), checkPath(NULL), only(NULL), perFrame(false) {}
+  bool parse(int argc, char **argv);
+};
+
+// What one tick cost on the bus
+struct BenchSample {
+  unsigned long pixels;
+  unsigned long primitives;
+  unsigned long spiBytes;
+  unsigned long addrWindows;
+};
+
+// stdout for eyes.dumpStats()
+struct BenchOut {
+  void print(const char *s) { fputs(s, stdout); }
+  void print(unsigned long v) { printf("%lu", v); }
+  void println(const char *s = "") { printf("%s\n", s); }
+};
+
+class Bench {
+public:
+  explicit Bench(const BenchOptions &opt);
+  ~Bench();
+
+  // Fresh clock and random sequence for a scenario; false if filtered out.
+  // loopsPerFrame > 1 calls update() that often per frame, like a busy loop().
+  bool start(const char *scenario, Adafruit_ST7789 &tft, uint16_t frameMs, uint16_t loopsPerFrame = 1);
+
+  // Advance the clock frame by frame for ms, calling eyes.update() on the way
+  template<typename Eyes>
+  void run(Eyes &eyes, unsigned long ms) {
+    if (_needBaseline) baseline();
+    for (unsigned long t = 0; t < ms; t += _frameMs) {
+      for (uint16_t i = 0; i < _loopsPerFrame; i++) {
+        hostAdvanceMillis(_frameMs / _loopsPerFrame + (i < _frameMs % _loopsPerFrame ? 1 : 0));
+        eyes.update();
+      }
+      sample();
+    }
+  }
+
+  // Same frames, but update() only at the deadline it returned last, the
+  // way a sketch that sleeps in between calls it; counts the calls
+  template<typename Eyes>
+  void runTickless(Eyes &eyes, unsigned long ms) {
+    if (_needBaseline) baseline();
+    for (unsigned long t = 0; t < ms; t += _frameMs) {
+      hostAdvanceMillis(_frameMs);
+      if ((long)(millis() - _wake) >= 0) {
+        _wake = eyes.update();
+        _wakeups++;
+      }
+      sample();
+    }
+  }
+
+  void sample();
+  void checkpoint(const char *label);
+  void finish();
+
+  // Same, and with ROBOEYES_PROFILE the frame profile of the scenario's eyes
+  template<typename Eyes>
+  void finish(Eyes &eyes) {
+    finish();
+#ifdef ROBOEYES_PROFILE
+    BenchOut out;
+    eyes.dumpStats(out);
+#else
+    (void)eyes;
+#endif
+  }
+
+  // Totals over all scenarios; returns the process exit code
+  int report();
+
+private:
+  BenchSample snapshot() const;
+  void baseline();
+  void loadGolden();
+
+  BenchOptions _opt;
+  Adafruit_ST7789 *_tft;
+  std::string _scenario;
+  uint16_t _frameMs;
+  uint16_t _loopsPerFrame;
+  unsigned long _wake, _wakeups;  // runTickless()
+  BenchSample _last, _sum, _max;
+  unsigned long _frames;
+  bool _needBaseline;
+  unsigned long _primBase[GFX_PRIM_COUNT];
+  unsigned long _totalFrames, _totalPixels, _totalSpiBytes;
+  unsigned long _checkpoints, _mismatches, _missing;
+  std::map<std::string, uint32_t> _golden;
+  FILE *_record;
+};
+
+#endif // HOST_BENCH_H
@@ -0,0 +1,27 @@
+/***************************************************
+ * Check.h - Minimal checks for the host tests
+ * EXPECT(cond, fmt, ...) prints the file, line and
+ * message of every check that fails and counts it;
+ * checkReport() sums up at the end of main() and
+ * gives its exit code.
+ ***************************************************/
+
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+#include <stdio.h>
+
+static int failures = 0;
+
+#define EXPECT(cond, ...) do { \
+    if (!(cond)) { failures++; printf("  FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); } \
+  } while (0)
+
+// "name: all checks passed" or the number of failures; 1 if any failed
+static inline int checkReport(const char *name) {
+  if (failures) printf("%s: %d failure(s)\n", name, failures);
+  else printf("%s: all checks passed\n", name);
+  return failures ? 1 : 0;
+}
+
+#endif // HOST_CHECK_H
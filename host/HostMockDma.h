@@ -0,0 +1,68 @@
+/***************************************************
+ * HostMockDma.h - Mock DMA backend for the host build
+ * A transfer takes the time the bytes would need on the
+ * SPI bus (virtual clock). Pixels are read from the
+ * strip buffer only when the transfer completes, so a
+ * buffer reused too early shows up in the frame.
+ ***************************************************/
+
+#ifndef HOST_MOCK_DMA_H
+#define HOST_MOCK_DMA_H
+
+#include <Adafruit_SPITFT.h>
+#include "RoboEyesDma.h"
+
+class HostMockDma : public RoboEyesDma {
+public:
+  explicit HostMockDma(Adafruit_SPITFT &display, uint32_t spiHz = 40000000UL)
+    : transfers(0), blockedUs(0), frozenClock(false), _display(display), _bytesPerMs(spiHz / 8 / 1000),
+      _active(false), _doneAt(0) {}
+
+  void start(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t *pixels) override {
+    _x = x; _y = y; _w = w; _h = h;
+    _pixels = pixels;
+    unsigned long bytes = 11 + (unsigned long)w * h * 2;
+    _doneAt = micros() + bytes * 1000UL / _bytesPerMs;
+    _active = true;
+    transfers++;
+  }
+
+  bool busy() override {
+    if (_active && (long)(micros() - _doneAt) >= 0) complete();
+    return _active;
+  }
+
+  // The CPU sits idle until the bus is done
+  void wait() override {
+    if (!_active) return;
+    long left = (long)(_doneAt - micros());
+    if (left > 0 && !frozenClock) {
+      blockedUs += left;
+      delayMicroseconds(left);
+    }
+    complete();
+  }
+
+  unsigned long transfers;
+  unsigned long blockedUs;  // time wait() stalled the caller
+  bool frozenClock;         // wait() finishes at once (harness peeking at a frame)
+
+private:
+  void complete() {
+    _display.startWrite();
+    _display.setAddrWindow(_x, _y, _w, _h);
+    _display.writePixels(_pixels, (uint32_t)_w * _h);
+    _display.endWrite();
+    _active = false;
+    finished();
+  }
+
+  Adafruit_SPITFT &_display;
+  unsigned long _bytesPerMs;
+  bool _active;
+  unsigned long _doneAt;
+  int16_t _x, _y, _w, _h;
+  uint16_t *_pixels;
+};
+
+#endif // HOST_MOCK_DMA_H
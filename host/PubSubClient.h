@@ -0,0 +1,74 @@
+/***************************************************
+ * PubSubClient.h - Host stand-in for the MQTT client
+ * A local broker the test switches on and off: connect()
+ * succeeds while it is up, loop() notices when it went
+ * away, and subscriptions are counted.
+ ***************************************************/
+
+#ifndef HOST_PUBSUBCLIENT_H
+#define HOST_PUBSUBCLIENT_H
+
+#include "Arduino.h"
+#include "WiFi.h"
+
+class HostBroker {
+public:
+  HostBroker() : up(true), connects(0), refused(0), subscribes(0), _session(0) {}
+
+  // Ends every client's connection
+  void drop() { _session++; }
+
+  bool up;
+  uint32_t connects, refused, subscribes;
+
+private:
+  friend class PubSubClient;
+  uint32_t _session;
+};
+
+class PubSubClient {
+public:
+  explicit PubSubClient(HostBroker &broker) : hostPort(0), _broker(broker), _connected(false), _session(0) {}
+
+  PubSubClient &setServer(IPAddress ip, uint16_t port) {
+    hostServer = ip;
+    hostPort = port;
+    return *this;
+  }
+
+  bool connect(const char *, const char *, const char *) {
+    if (!_broker.up) {
+      _broker.refused++;
+      _connected = false;
+      return false;
+    }
+    _broker.connects++;
+    _connected = true;
+    _session = _broker._session;
+    return true;
+  }
+
+  bool subscribe(const char *topic) {
+    if (!connected() || !topic) return false;
+    _broker.subscribes++;
+    return true;
+  }
+
+  bool connected() {
+    if (_connected && (!_broker.up || _session != _broker._session)) _connected = false;
+    return _connected;
+  }
+
+  bool loop() { return connected(); }
+
+  // Host only: the address last given to setServer()
+  IPAddress hostServer;
+  uint16_t hostPort;
+
+private:
+  HostBroker &_broker;
+  bool _connected;
+  uint32_t _session;
+};
+
+#endif // HOST_PUBSUBCLIENT_H
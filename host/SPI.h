@@ -0,0 +1,18 @@
+/***************************************************
+ * SPI.h - Host stand-in (no bus on the host)
+ ***************************************************/
+
+#ifndef HOST_SPI_H
+#define HOST_SPI_H
+
+#include "Arduino.h"
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+};
+
+extern SPIClass SPI;
+
+#endif // HOST_SPI_H
@@ -0,0 +1,83 @@
+/***************************************************
+ * WiFi.h - Host stand-in for the ESP32 WiFi station
+ * No radio: the test says whether the network is in
+ * reach and how long a join takes on the virtual clock.
+ ***************************************************/
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include "Arduino.h"
+
+// Just enough of Arduino's IPAddress to carry a looked-up broker
+class IPAddress {
+public:
+  IPAddress() : _addr(0) {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+    : _addr((uint32_t)a << 24 | (uint32_t)b << 16 | (uint32_t)c << 8 | d) {}
+  bool operator==(const IPAddress &o) const { return _addr == o._addr; }
+  bool operator!=(const IPAddress &o) const { return _addr != o._addr; }
+
+private:
+  uint32_t _addr;
+};
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL = 1,
+  WL_CONNECTED = 3,
+  WL_CONNECT_FAILED = 4,
+  WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+  WiFiClass()
+    : hostInReach(true), hostJoinMs(2000), hostBegins(0), hostDnsUp(true), hostLookups(0),
+      _joining(false), _startedAt(0) {}
+
+  wl_status_t begin(const char *, const char *) {
+    hostBegins++;
+    _joining = true;
+    _startedAt = millis();
+    return status();
+  }
+
+  bool disconnect() {
+    _joining = false;
+    return true;
+  }
+
+  // Connected once a join has run hostJoinMs with the network in reach
+  wl_status_t status() {
+    if (!_joining) return WL_DISCONNECTED;
+    if (!hostInReach) return WL_NO_SSID_AVAIL;
+    return millis() - _startedAt >= hostJoinMs ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+
+  // 1 and the broker's address while connected and DNS answers, else 0
+  int hostByName(const char *, IPAddress &result) {
+    hostLookups++;
+    if (status() != WL_CONNECTED || !hostDnsUp) return 0;
+    result = IPAddress(10, 0, 0, 2);
+    return 1;
+  }
+
+  // Host only: the network goes away (and the association with it)
+  void hostDrop() {
+    hostInReach = false;
+    _joining = false;
+  }
+
+  bool hostInReach;
+  unsigned long hostJoinMs;
+  uint32_t hostBegins;
+  bool hostDnsUp;
+  uint32_t hostLookups;
+
+private:
+  bool _joining;
+  unsigned long _startedAt;
+};
+
+#endif // HOST_WIFI_H
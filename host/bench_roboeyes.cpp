@@ -0,0 +1,117 @@
+/***************************************************
+ * bench_roboeyes.cpp - Scripted benchmark for RoboEyes.cpp
+ * Same setup as RoboEyesDemo (320x240 landscape, 30 FPS).
+ ***************************************************/
+
+#include "Bench.h"
+#include "RoboEyes.h"
+
+static const uint16_t FRAME_MS = 1000 / 30;
+
+static void setupEyes(Adafruit_ST7789 &tft, RoboEyes &eyes) {
+  tft.init(240, 320);
+  tft.setRotation(1);
+  eyes.begin(320, 240, 30);
+  eyes.setColors(ST77XX_BLACK, ST77XX_CYAN);
+}
+
+// format: pixels of the composited pushes; black and cyan are exact in
+// RGB444, so every checkpoint must match the RGB565 run. indexed: 1-bpp
+// full-screen canvas, same pixels again
+static void moods(Bench &bench, const char *name, bool compositing,
+                  EyePixelFormat format = EYE_PIXELS_RGB565, bool indexed = false) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+  if (compositing) eyes.setCompositing(true, 0, indexed);
+  eyes.setPixelFormat(format);
+
+  static const char *const labels[] = { "default", "happy", "sad", "angry", "tired" };
+  for (uint8_t m = MOOD_DEFAULT; m <= MOOD_TIRED; m++) {
+    eyes.setMood((Mood)m);
+    bench.run(eyes, 1000);
+    bench.checkpoint(labels[m]);
+  }
+  bench.finish(eyes);
+}
+
+static void positions(Bench &bench) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes eyes(tft);
+  if (!bench.start("positions", tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+
+  static const char *const labels[] = { "center", "n", "ne", "e", "se", "s", "sw", "w", "nw" };
+  for (uint8_t p = POS_N; p <= POS_NW; p++) {
+    eyes.setPosition((Position)p);
+    bench.run(eyes, 800);
+    bench.checkpoint(labels[p]);
+  }
+  eyes.setPosition(POS_DEFAULT);
+  bench.run(eyes, 800);
+  bench.checkpoint(labels[POS_DEFAULT]);
+  bench.finish(eyes);
+}
+
+static void effects(Bench &bench) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes eyes(tft);
+  if (!bench.start("effects", tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+
+  eyes.blink();
+  bench.run(eyes, 500);
+  bench.checkpoint("blink");
+  eyes.setSweat(true);
+  bench.run(eyes, 1500);
+  bench.checkpoint("sweat");
+  eyes.setSweat(false);
+  eyes.setCuriosity(true);
+  eyes.setPosition(POS_E);
+  bench.run(eyes, 1000);
+  bench.checkpoint("curious");
+  eyes.anim_confused();
+  bench.run(eyes, 1000);
+  bench.checkpoint("confused");
+  eyes.anim_laugh();
+  bench.run(eyes, 1000);
+  bench.checkpoint("laugh");
+  eyes.setCyclops(true);
+  bench.run(eyes, 1000);
+  bench.checkpoint("cyclops");
+  bench.finish(eyes);
+}
+
+static void idle(Bench &bench) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes eyes(tft);
+  if (!bench.start("idle", tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+
+  eyes.setAutoBlinker(true, 3, 2);
+  eyes.setIdleMode(true, 2, 1);
+  for (uint8_t i = 0; i < 5; i++) {
+    bench.run(eyes, 2000);
+    char label[8];
+    snprintf(label, sizeof(label), "t%u", (unsigned)(i + 1) * 2);
+    bench.checkpoint(label);
+  }
+  bench.finish(eyes);
+}
+
+int main(int argc, char **argv) {
+  BenchOptions opt;
+  if (!opt.parse(argc, argv)) return 2;
+
+  Bench bench(opt);
+  moods(bench, "moods", false);
+  moods(bench, "moods-composited", true);
+  moods(bench, "moods-composited-444", true, EYE_PIXELS_RGB444);
+  moods(bench, "moods-indexed", true, EYE_PIXELS_RGB565, true);
+  moods(bench, "moods-indexed-444", true, EYE_PIXELS_RGB444, true);
+  positions(bench);
+  effects(bench);
+  idle(bench);
+  return bench.report();
+}
@@ -0,0 +1,254 @@
+/***************************************************
+ * bench_roboeyes_v2.cpp - Scripted benchmark for the
+ * RoboEyes<AdafruitDisplay> template (FluxGarage V2)
+ * Same setup as RoboEyesDemo.ino: 320x240 landscape,
+ * 80x100 eyes, 30 FPS; the portrait runs are 240x320.
+ ***************************************************/
+
+// Standard headers first: the template defines short macros (N, E, S, ...)
+#include "Bench.h"
+#include "FluxGarage_RoboEyesV2.txt"
+#include "HostMockDma.h"
+#include "RoboEyesBatch.h"
+
+static const uint16_t FRAME_MS = 1000 / 30;
+
+typedef EyeBatchedPanel<Adafruit_ST7789> BatchedST7789;
+
+// What EyeBatchedPanel<> kept off the bus
+static void batchStats(Adafruit_ST7789 &) {}
+static void batchStats(BatchedST7789 &tft) {
+  const EyeBatchStats &st = tft.batchStats();
+  printf("  batch: %lu transactions (%lu saved), %lu windows (%lu continued), %lu commands / %lu bytes saved\n",
+         (unsigned long)st.transactions, (unsigned long)st.transactionsSaved, (unsigned long)st.windows,
+         (unsigned long)st.windowsContinued, (unsigned long)st.commandsSaved, (unsigned long)st.bytesSaved);
+}
+
+template<typename Panel>
+static void setupEyes(Panel &tft, RoboEyes<Panel> &eyes) {
+  tft.init(240, 320);
+  tft.setRotation(1);
+  tft.fillScreen(ST77XX_BLACK);
+  eyes.begin(320, 240, 30);
+  eyes.setWidth(80, 80);
+  eyes.setHeight(100, 100);
+  eyes.setBorderradius(30, 30);
+  eyes.setSpacebetween(5);
+  eyes.setDisplayColors(ST77XX_BLACK, ST77XX_CYAN);
+}
+
+// Let the last frame reach the panel without moving the clock, so the run
+// stays frame-for-frame comparable with the direct one
+template<typename Panel>
+static void drain(RoboEyes<Panel> &eyes, HostMockDma &dma) {
+  dma.frozenClock = true;
+  eyes.waitForFlush();
+  dma.frozenClock = false;
+}
+
+// dma: strips go through the mock DMA backend, loop() polls every millisecond.
+// Panel: EyeBatchedPanel<> must give the same frames with less traffic.
+template<typename Panel>
+static void moods(Bench &bench, const char *name, bool dma) {
+  Panel tft(5, 16, 17);
+  HostMockDma mockDma(tft);
+  RoboEyes<Panel> eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS, dma ? FRAME_MS : 1)) return;
+  setupEyes(tft, eyes);
+  if (dma) eyes.setStripFlush(&mockDma);
+
+  static const char *const labels[] = {
+    "default", "happy", "sad", "angry", "tired", "sleep", "glee", "worried", "focused",
+    "annoyed", "surprised", "skeptic", "frustrated", "suspicious", "squint", "furious",
+    "scared", "awe"
+  };
+  for (uint8_t m = HAPPY; m <= AWE; m++) {
+    eyes.setMood(m);
+    bench.run(eyes, 800);
+    drain(eyes, mockDma);
+    bench.checkpoint(labels[m]);
+  }
+  eyes.setMood(DEFAULT);
+  bench.run(eyes, 800);
+  drain(eyes, mockDma);
+  bench.checkpoint(labels[DEFAULT]);
+  bench.finish(eyes);
+  if (dma) printf("  dma: %lu transfers, %lu us blocked\n", mockDma.transfers, mockDma.blockedUs);
+  batchStats(tft);
+}
+
+// format: pixels of the flush; black and cyan are exact in RGB444, so every
+// checkpoint must match the RGB565 run
+template<typename Panel>
+static void positions(Bench &bench, const char *name, uint8_t format) {
+  Panel tft(5, 16, 17);
+  RoboEyes<Panel> eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+  eyes.setPixelFormat(format);
+
+  static const char *const labels[] = { "center", "n", "ne", "e", "se", "s", "sw", "w", "nw" };
+  for (uint8_t p = N; p <= NW; p++) {
+    eyes.setPositionAuto(p);
+    bench.run(eyes, 800);
+    bench.checkpoint(labels[p]);
+  }
+  eyes.setPositionAuto(DEFAULT);
+  bench.run(eyes, 800);
+  bench.checkpoint(labels[DEFAULT]);
+  bench.finish(eyes);
+  batchStats(tft);
+}
+
+// scroll: whole-face motion along x (confused, hflicker) goes through the
+// panel's hardware scroll; every checkpoint must match the plain run
+template<typename Panel>
+static void effects(Bench &bench, const char *name, bool scroll) {
+  Panel tft(5, 16, 17);
+  RoboEyes<Panel> eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+  if (scroll) eyes.setHardwareScroll(ON);
+
+  bench.run(eyes, 500);
+  eyes.blink();
+  bench.run(eyes, 500);
+  bench.checkpoint("blink");
+  eyes.setSweat(ON);
+  bench.run(eyes, 1500);
+  bench.checkpoint("sweat");
+  eyes.setSweat(OFF);
+  eyes.anim_confused();
+  bench.run(eyes, 1000);
+  bench.checkpoint("confused");
+  eyes.anim_laugh();
+  bench.run(eyes, 1000);
+  bench.checkpoint("laugh");
+  eyes.setHFlicker(ON, 2);
+  bench.run(eyes, 500);
+  eyes.setHFlicker(OFF);
+  bench.checkpoint("hflicker");
+  eyes.setVFlicker(ON, 2);
+  bench.run(eyes, 500);
+  eyes.setVFlicker(OFF);
+  bench.checkpoint("vflicker");
+  eyes.setCyclops(ON);
+  bench.run(eyes, 1000);
+  bench.checkpoint("cyclops");
+  bench.finish(eyes);
+  batchStats(tft);
+}
+
+// Portrait like RoboEyesDemo.ino, where laugh, vflicker and sway run along
+// the scan lines. Rotation 0 scrolls the other way round than rotation 2.
+template<typename Panel>
+static void portrait(Bench &bench, const char *name, uint8_t rotation, bool scroll) {
+  Panel tft(5, 16, 17);
+  RoboEyes<Panel> eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS)) return;
+  tft.init(240, 320);
+  tft.setRotation(rotation);
+  tft.fillScreen(ST77XX_BLACK);
+  eyes.begin(240, 320, 30);
+  eyes.setWidth(80, 80);
+  eyes.setHeight(100, 100);
+  eyes.setBorderradius(30, 30);
+  eyes.setSpacebetween(5);
+  eyes.setDisplayColors(ST77XX_BLACK, ST77XX_CYAN);
+  eyes.setPosition(DEFAULT);
+  if (scroll) eyes.setHardwareScroll(ON);
+
+  bench.run(eyes, 500);
+  eyes.anim_laugh();
+  bench.run(eyes, 1000);
+  bench.checkpoint("laugh");
+  eyes.setVFlicker(ON, 2);
+  bench.run(eyes, 500);
+  eyes.setVFlicker(OFF);
+  bench.checkpoint("vflicker");
+  eyes.setMood(SCARED);
+  bench.run(eyes, 2000);
+  bench.checkpoint("sway");
+  eyes.setMood(DEFAULT);
+  eyes.setSweat(ON);
+  eyes.anim_laugh();
+  bench.run(eyes, 1000);
+  bench.checkpoint("laugh-sweat");
+  eyes.setSweat(OFF);
+  eyes.setPositionAuto(N);
+  bench.run(eyes, 800);
+  eyes.anim_laugh();
+  bench.run(eyes, 1000);
+  bench.checkpoint("laugh-top");
+  eyes.setHardwareScroll(OFF);
+  eyes.setPositionAuto(DEFAULT);
+  bench.run(eyes, 800);
+  bench.checkpoint("center");
+  bench.finish(eyes);
+  batchStats(tft);
+}
+
+static void idle(Bench &bench) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes<Adafruit_ST7789> eyes(tft);
+  if (!bench.start("idle", tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+
+  eyes.setAutoblinker(ON, 3, 2);
+  eyes.setIdleMode(ON, 2, 1);
+  for (uint8_t i = 0; i < 5; i++) {
+    bench.run(eyes, 2000);
+    char label[8];
+    snprintf(label, sizeof(label), "t%u", (unsigned)(i + 1) * 2);
+    bench.checkpoint(label);
+  }
+  bench.finish(eyes);
+}
+
+// A face with nothing running on its own but blinks and micro-saccades.
+// tickless: update() only at the deadlines it returns, which must give the
+// same frames as calling it every tick
+static void rest(Bench &bench, const char *name, bool tickless) {
+  Adafruit_ST7789 tft(5, 16, 17);
+  RoboEyes<Adafruit_ST7789> eyes(tft);
+  if (!bench.start(name, tft, FRAME_MS)) return;
+  setupEyes(tft, eyes);
+  eyes.setPosition(DEFAULT);
+  eyes.setMoodAnimation(OFF, 0);
+  eyes.setAutoblinker(ON, 3, 2);
+
+  for (uint8_t i = 0; i < 5; i++) {
+    if (tickless) bench.runTickless(eyes, 2000);
+    else bench.run(eyes, 2000);
+    char label[8];
+    snprintf(label, sizeof(label), "t%u", (unsigned)(i + 1) * 2);
+    bench.checkpoint(label);
+  }
+  bench.finish(eyes);
+}
+
+int main(int argc, char **argv) {
+  BenchOptions opt;
+  if (!opt.parse(argc, argv)) return 2;
+
+  Bench bench(opt);
+  moods<Adafruit_ST7789>(bench, "moods", false);
+  moods<Adafruit_ST7789>(bench, "moods-dma", true);
+  moods<BatchedST7789>(bench, "moods-batched", false);
+  moods<BatchedST7789>(bench, "moods-dma-batched", true);
+  positions<Adafruit_ST7789>(bench, "positions", EYE_PIXELS_RGB565);
+  positions<Adafruit_ST7789>(bench, "positions-444", EYE_PIXELS_RGB444);
+  positions<BatchedST7789>(bench, "positions-batched", EYE_PIXELS_RGB565);
+  positions<BatchedST7789>(bench, "positions-444-batched", EYE_PIXELS_RGB444);
+  effects<Adafruit_ST7789>(bench, "effects", false);
+  effects<Adafruit_ST7789>(bench, "effects-scroll", true);
+  effects<BatchedST7789>(bench, "effects-scroll-batched", true);
+  portrait<Adafruit_ST7789>(bench, "portrait", 2, false);
+  portrait<Adafruit_ST7789>(bench, "portrait-scroll", 2, true);
+  portrait<Adafruit_ST7789>(bench, "portrait-flipped-scroll", 0, true);
+  portrait<BatchedST7789>(bench, "portrait-scroll-batched", 2, true);
+  idle(bench);
+  rest(bench, "rest", false);
+  rest(bench, "rest-tickless", true);
+  return bench.report();
+}
@@ -0,0 +1,179 @@
+/***************************************************
+ * test_batch.cpp - Checks for RoboEyesBatch.h: random
+ * Adafruit_GFX drawing, and the FluxGarage eyes of
+ * RoboEyesDemo.ino, must leave the same GRAM behind
+ * through EyeBatchedPanel<> as through the plain
+ * driver, with one transaction per frame and exactly
+ * the bytes its counters claim to have saved.
+ ***************************************************/
+
+// Standard headers first: the template defines short macros (N, E, S, ...)
+#include <Arduino.h>
+#include <Adafruit_ST7789.h>
+#include "RoboEyesBatch.h"
+#include "Check.h"
+#include <vector>
+#include "FluxGarage_RoboEyes.h"
+
+typedef EyeBatchedPanel<Adafruit_ST7789> BatchedST7789;
+
+static uint16_t pixels[64 * 64];
+
+// One random primitive, the same on both panels
+template<typename Panel>
+static void drawRandom(Panel &tft, uint32_t pick) {
+  int16_t x = random(-20, 260), y = random(-20, 340);
+  int16_t w = random(1, 90), h = random(1, 90);
+  uint16_t color = random(0x10000);
+  switch (pick % 8) {
+    case 0: tft.fillRect(x, y, w, h, color); break;
+    case 1: tft.drawFastHLine(x, y, w, color); break;
+    case 2: tft.drawFastVLine(x, y, h, color); break;
+    case 3: tft.drawPixel(x, y, color); break;
+    case 4: tft.fillRoundRect(x, y, w, h, min(w, h) / 3, color); break;
+    case 5: tft.fillTriangle(x, y, x + w, y + random(-40, 40), x + random(-40, 40), y + h, color); break;
+    case 6: tft.drawRGBBitmap(x, y, pixels, min(w, (int16_t)64), min(h, (int16_t)64)); break;
+    default:
+      // A run of rows the way the span renderer sends them
+      tft.startWrite();
+      for (int16_t r = 0; r < h; r++) {
+        int16_t cut = x + random(w + 1);
+        tft.writeFastHLine(x, y + r, cut - x, color);
+        tft.writeFastHLine(cut, y + r, x + w - cut, ~color);
+      }
+      tft.endWrite();
+      break;
+  }
+}
+
+static void fuzz() {
+  Adafruit_ST7789 plain(5, 16, -1);
+  BatchedST7789 batched(5, 16, -1);
+  for (uint16_t i = 0; i < 64 * 64; i++) pixels[i] = i * 2654435761UL >> 16;
+  plain.init(240, 320);
+  batched.init(240, 320);
+
+  uint32_t mismatches = 0;
+  for (uint16_t frame = 0; frame < 400; frame++) {
+    // Now and then what resets the pointer: rotation, 12 bpp
+    if (frame % 50 == 25) {
+      plain.setRotation(frame / 50);
+      batched.setRotation(frame / 50);
+    }
+    uint8_t colmod = (frame % 100 < 20) ? 0x53 : 0x55;
+    plain.sendCommand(ST77XX_COLMOD, &colmod, 1);
+    batched.beginFrame();
+    batched.sendCommand(ST77XX_COLMOD, &colmod, 1);
+
+    uint32_t seed = random(0x7FFFFFFF);
+    for (uint8_t k = 0; k < 2; k++) {
+      randomSeed(seed);
+      for (uint8_t op = 0; op < 12; op++) {
+        uint32_t pick = random(0x7FFFFFFF);
+        if (k) drawRandom(batched, pick);
+        else drawRandom(plain, pick);
+        // A command between runs ends the pixel stream (VSCSAD, as the
+        // hardware scroll sends it mid-frame)
+        if (op % 4 == 3) {
+          static const uint8_t top[2] = { 0, 0 };
+          if (k) batched.sendCommand(0x37, top, 2);
+          else plain.sendCommand(0x37, top, 2);
+        }
+      }
+    }
+    batched.endFrame();
+    if (plain.hostFrameChecksum() != batched.hostFrameChecksum()) mismatches++;
+  }
+
+  const EyeBatchStats &st = batched.batchStats();
+  const SPITFTHostStats &p = plain.hostStats(), &b = batched.hostStats();
+  EXPECT(mismatches == 0, "%u of 400 frames differ", (unsigned)mismatches);
+  EXPECT(b.dropped == 0, "%lu pixels sent outside RAMWR", b.dropped);
+  EXPECT(p.spiBytes - b.spiBytes == st.bytesSaved, "%lu bytes fewer on the bus, %lu counted as saved",
+         p.spiBytes - b.spiBytes, (unsigned long)st.bytesSaved);
+  EXPECT(b.transactions == st.transactions, "%lu transactions on the bus, %lu counted",
+         b.transactions, (unsigned long)st.transactions);
+  EXPECT(st.windowsContinued > 0 && st.commandsSaved > 0, "nothing saved");
+  printf("fuzz:     %lu -> %lu bytes, %lu -> %lu transactions, %lu of %lu windows continued\n",
+         p.spiBytes, b.spiBytes, p.transactions, b.transactions, (unsigned long)st.windowsContinued,
+         (unsigned long)st.windows);
+}
+
+// A run that continues the last one, but after a command: the panel has
+// left RAMWR, so the window must be opened again
+static void commandEndsStream() {
+  BatchedST7789 tft(5, 16, -1);
+  tft.init(240, 320);
+  static const uint8_t top[2] = { 0, 0 };
+  tft.beginFrame();
+  tft.startWrite();
+  tft.writeFastHLine(10, 10, 20, ST77XX_CYAN);
+  tft.sendCommand(0x37, top, 2);
+  tft.writeFastHLine(30, 10, 20, ST77XX_RED);
+  tft.endWrite();
+  tft.endFrame();
+  EXPECT(tft.hostStats().dropped == 0, "%lu pixels sent outside RAMWR", tft.hostStats().dropped);
+  EXPECT(tft.hostPixel(30, 10) == ST77XX_RED, "run after the command not drawn");
+  EXPECT(tft.batchStats().windowsContinued == 0, "window continued across a command");
+}
+
+// The demo's eyes, frame by frame; random() and the clock start over for each
+template<typename Panel>
+static void runEyes(Panel &tft, std::vector<uint32_t> &frames) {
+  hostSetMillis(0);
+  randomSeed(7);
+  RoboEyes<Panel> eyes(tft);
+  tft.init(240, 320);
+  tft.setRotation(2);
+  tft.hostResetStats();
+  eyes.begin(240, 320, 15);
+  eyes.setWidth(40, 40);
+  eyes.setHeight(50, 50);
+  eyes.setBorderradius(15, 15);
+  eyes.setSpacebetween(40);
+  eyes.setDisplayColors(ST77XX_BLACK, ST77XX_CYAN);
+  eyes.setAutoblinker(ON, 2, 1);
+  eyes.setIdleMode(ON, 2, 1);
+  for (uint16_t i = 0; i < 300; i++) {
+    if (i == 60) eyes.setMood(HAPPY);
+    if (i == 120) { eyes.setMood(TIRED); eyes.setSweat(ON); }
+    if (i == 180) { eyes.setMood(ANGRY); eyes.anim_laugh(); }
+    if (i == 240) { eyes.setCyclops(ON); eyes.anim_confused(); }
+    hostAdvanceMillis(1000 / 15);
+    eyes.drawEyes();
+    frames.push_back(tft.hostFrameChecksum());
+  }
+}
+
+static void eyesV1() {
+  Adafruit_ST7789 plain(5, 16, -1);
+  BatchedST7789 batched(5, 16, -1);
+  std::vector<uint32_t> a, b;
+  runEyes(plain, a);
+  runEyes(batched, b);
+
+  uint32_t mismatches = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i] != b[i]) mismatches++;
+  }
+  const EyeBatchStats &st = batched.batchStats();
+  const SPITFTHostStats &p = plain.hostStats(), &q = batched.hostStats();
+  EXPECT(a.size() == b.size() && mismatches == 0, "%u of %u frames differ", (unsigned)mismatches,
+         (unsigned)a.size());
+  // begin()'s fillScreen, then one per frame
+  EXPECT(q.transactions == 1 + a.size(), "%lu transactions for %u frames", q.transactions,
+         (unsigned)a.size());
+  EXPECT(p.spiBytes - q.spiBytes == st.bytesSaved, "%lu bytes fewer on the bus, %lu counted as saved",
+         p.spiBytes - q.spiBytes, (unsigned long)st.bytesSaved);
+  printf("eyes v1:  per frame %lu -> %lu bytes, %lu -> %lu transactions, %lu of %lu windows continued\n",
+         p.spiBytes / a.size(), q.spiBytes / a.size(), p.transactions / a.size(),
+         q.transactions / a.size(), (unsigned long)st.windowsContinued, (unsigned long)st.windows);
+}
+
+int main() {
+  randomSeed(1);
+  fuzz();
+  commandEndsStream();
+  eyesV1();
+  return checkReport("batch");
+}
@@ -0,0 +1,189 @@
+/***************************************************
+ * test_link.cpp - Checks for QrLink.h against the
+ * WiFi and broker stand-ins on the virtual clock: the
+ * bring-up order, backoff growth, cap and jitter while
+ * the broker is down, recovery after WiFi or broker
+ * loss, one broker lookup per join, and that listeners
+ * only hear real changes.
+ ***************************************************/
+
+#include <Arduino.h>
+#include "QrLink.h"
+#include "Check.h"
+#include <vector>
+
+static const unsigned long POLL_MS = 10;  // the sketch's loop() period
+
+static std::vector<uint8_t> changes;
+
+static void record(uint8_t from, uint8_t to) {
+  EXPECT(from != to, "listener called without a change (%u)", to);
+  changes.push_back(to);
+}
+
+struct Rig {
+  WiFiClass wifi;
+  HostBroker broker;
+  PubSubClient mqtt;
+  QrLink link;
+
+  Rig() : mqtt(broker), link(wifi, mqtt) {
+    hostSetMillis(0);
+    changes.clear();
+    link.setBroker("ESP32_test", "user", "secret", "CASSOROBOT/qr");
+    link.setServer("broker.test", 1883);
+    link.onChange(record);
+  }
+
+  // Poll every POLL_MS for ms; stops early once online if asked to
+  void run(unsigned long ms, bool untilOnline = false) {
+    for (unsigned long t = 0; t < ms; t += POLL_MS) {
+      link.poll(millis());
+      if (untilOnline && link.online()) return;
+      hostAdvanceMillis(POLL_MS);
+    }
+  }
+};
+
+static bool changedTo(const uint8_t *expected, size_t n) {
+  if (changes.size() != n) return false;
+  for (size_t i = 0; i < n; i++) {
+    if (changes[i] != expected[i]) return false;
+  }
+  return true;
+}
+
+static void bringUp() {
+  Rig r;
+  r.link.begin("dev", "pass", millis());
+  r.run(10000, true);
+  static const uint8_t order[] = { QR_LINK_WIFI_JOINING, QR_LINK_MQTT_BACKOFF, QR_LINK_ONLINE };
+  EXPECT(changedTo(order, 3), "bring-up went through %u states", (unsigned)changes.size());
+  EXPECT(millis() >= r.wifi.hostJoinMs && millis() < r.wifi.hostJoinMs + 2 * POLL_MS,
+         "online at %lu ms", millis());
+  EXPECT(r.broker.connects == 1 && r.broker.subscribes == 1, "%u connects, %u subscribes",
+         (unsigned)r.broker.connects, (unsigned)r.broker.subscribes);
+
+  // Staying online changes nothing
+  r.run(60000);
+  EXPECT(changes.size() == 3 && r.broker.connects == 1, "online link reconnected");
+  printf("bring-up: online after %lu ms\n", r.wifi.hostJoinMs);
+}
+
+// Broker down: tries spread out with each failure, never past the cap,
+// and not by exact powers of two
+static void brokerOutage() {
+  Rig r;
+  r.broker.up = false;
+  r.link.begin("dev", "pass", millis());
+  r.run(r.wifi.hostJoinMs + POLL_MS);
+
+  std::vector<unsigned long> tries;
+  unsigned long lastRefused = r.broker.refused;
+  for (unsigned long t = 0; t < 300000; t += POLL_MS) {
+    r.link.poll(millis());
+    if (r.broker.refused != lastRefused) {
+      lastRefused = r.broker.refused;
+      tries.push_back(millis());
+    }
+    hostAdvanceMillis(POLL_MS);
+  }
+
+  bool grows = true, capped = true, jittered = false;
+  for (size_t i = 1; i < tries.size(); i++) {
+    unsigned long gap = tries[i] - tries[i - 1];
+    unsigned long full = min(QR_LINK_BACKOFF_MIN_MS << min((size_t)16, i - 1), QR_LINK_BACKOFF_MAX_MS);
+    if (gap + POLL_MS < full / 2 || gap > full + POLL_MS) grows = false;
+    if (gap > QR_LINK_BACKOFF_MAX_MS + POLL_MS) capped = false;
+    if (gap != full && gap != full + POLL_MS) jittered = true;
+  }
+  EXPECT(tries.size() > 8, "only %u tries in 5 minutes", (unsigned)tries.size());
+  EXPECT(grows, "retry gaps outside 50-100 %% of the doubling delay");
+  EXPECT(capped, "a retry gap past the cap");
+  EXPECT(jittered, "no jitter in the retry gaps");
+  EXPECT(r.link.state() == QR_LINK_MQTT_BACKOFF, "state %u during the outage", r.link.state());
+  static const uint8_t order[] = { QR_LINK_WIFI_JOINING, QR_LINK_MQTT_BACKOFF };
+  EXPECT(changedTo(order, 2), "%u state changes during the outage", (unsigned)changes.size());
+
+  // Back within one capped delay
+  r.broker.up = true;
+  unsigned long back = millis();
+  r.run(QR_LINK_BACKOFF_MAX_MS + POLL_MS, true);
+  EXPECT(r.link.online(), "not online %lu ms after the broker came back", millis() - back);
+  EXPECT(r.link.attempts() == 0, "attempts not reset");
+  printf("broker:   %u tries in 5 min down, back online after %lu ms\n", (unsigned)tries.size(),
+         millis() - back);
+}
+
+static void recoveries() {
+  Rig r;
+  r.link.begin("dev", "pass", millis());
+  r.run(10000, true);
+
+  // Broker restarts: first retry within the minimum delay
+  r.broker.drop();
+  r.link.poll(millis());
+  EXPECT(r.link.state() == QR_LINK_MQTT_BACKOFF, "broker drop not noticed");
+  unsigned long dropped = millis();
+  r.run(QR_LINK_BACKOFF_MIN_MS + POLL_MS, true);
+  EXPECT(r.link.online() && millis() - dropped <= QR_LINK_BACKOFF_MIN_MS, "back after %lu ms",
+         millis() - dropped);
+
+  // WiFi gone for a minute: joins time out and back off, then it rejoins
+  changes.clear();
+  r.wifi.hostDrop();
+  r.run(60000);
+  EXPECT(!changes.empty() && changes[0] == QR_LINK_WIFI_JOINING, "WiFi loss not noticed");
+  EXPECT(r.wifi.hostBegins >= 3, "only %u joins in a minute", (unsigned)r.wifi.hostBegins);
+  r.wifi.hostInReach = true;
+  r.run(QR_LINK_JOIN_TIMEOUT_MS + QR_LINK_BACKOFF_MAX_MS + r.wifi.hostJoinMs, true);
+  EXPECT(r.link.online(), "not back online after WiFi returned");
+  EXPECT(r.broker.subscribes == 3, "%u subscribes", (unsigned)r.broker.subscribes);
+  printf("recovery: %u WiFi joins, %u state changes\n", (unsigned)r.wifi.hostBegins,
+         (unsigned)changes.size());
+}
+
+// The broker's name is looked up once per join, not on every retry; a
+// failed lookup backs off like a refused connect
+static void brokerLookup() {
+  Rig r;
+  r.wifi.hostDnsUp = false;
+  r.broker.up = false;
+  r.link.begin("dev", "pass", millis());
+  r.run(60000);
+  uint32_t failedLookups = r.wifi.hostLookups;
+  EXPECT(r.broker.connects + r.broker.refused == 0, "connected without an address");
+  EXPECT(failedLookups > 3 && r.link.state() == QR_LINK_MQTT_BACKOFF, "%u lookups, state %u",
+         (unsigned)failedLookups, r.link.state());
+
+  // DNS answers, the broker still refuses: retries reuse the address
+  r.wifi.hostDnsUp = true;
+  r.run(120000);
+  EXPECT(r.wifi.hostLookups == failedLookups + 1, "%u lookups once DNS answered",
+         (unsigned)(r.wifi.hostLookups - failedLookups));
+  EXPECT(r.broker.refused > 3, "only %u tries", (unsigned)r.broker.refused);
+  EXPECT(r.mqtt.hostServer == IPAddress(10, 0, 0, 2) && r.mqtt.hostPort == 1883, "address not handed over");
+
+  r.broker.up = true;
+  r.run(QR_LINK_BACKOFF_MAX_MS + POLL_MS, true);
+  EXPECT(r.link.online(), "not online once the broker came back");
+
+  // A new join looks the name up again
+  r.wifi.hostDrop();
+  r.run(1000);
+  r.wifi.hostInReach = true;
+  r.run(QR_LINK_JOIN_TIMEOUT_MS + QR_LINK_BACKOFF_MAX_MS + r.wifi.hostJoinMs, true);
+  EXPECT(r.link.online() && r.wifi.hostLookups == failedLookups + 2, "%u lookups after a rejoin",
+         (unsigned)(r.wifi.hostLookups - failedLookups));
+  printf("lookup:   %u while DNS was down, then one per join over %u tries\n", (unsigned)failedLookups,
+         (unsigned)r.broker.refused);
+}
+
+int main() {
+  randomSeed(1);
+  bringUp();
+  brokerOutage();
+  recoveries();
+  brokerLookup();
+  return checkReport("link");
+}
@@ -0,0 +1,418 @@
+/***************************************************
+ * test_qr.cpp - Checks for QrEncode.h
+ * The payment string behind matrix-qr.txt must encode
+ * to exactly that matrix, and every version and ECC
+ * level must read back: format and version words, RS
+ * syndromes of every block and the text itself, by a
+ * reader that shares no code with the encoder. Also
+ * QrCache.h over an in-memory file system: LRU in RAM
+ * and flash, no flash writes on hits, and a reboot.
+ ***************************************************/
+
+#include <Arduino.h>
+#include "QrEncode.h"
+#include "QrPayload.h"
+#include "QrCache.h"
+#include "Check.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// The text matrix-qr.txt holds (version 6-M, mask 2)
+static const char *FIXTURE_TEXT =
+  "00020101021138590010A000000727012900069704180115V3CASLTHCH4YXN60208QRIBFTTA53037045802VN63048B05";
+
+static std::vector<uint8_t> readFile(const char *path) {
+  std::vector<uint8_t> data;
+  FILE *f = fopen(path, "rb");
+  if (!f) return data;
+  int c;
+  while ((c = fgetc(f)) != EOF) data.push_back(c);
+  fclose(f);
+  return data;
+}
+
+static uint32_t differences(const QrMatrix &a, const QrMatrix &b) {
+  if (a.size() != b.size()) return 0xFFFFFFFF;
+  uint32_t n = 0;
+  for (uint8_t y = 0; y < a.size(); y++) {
+    for (uint8_t x = 0; x < a.size(); x++) n += a.get(x, y) != b.get(x, y);
+  }
+  return n;
+}
+
+static QrMatrix fixture, encoded, streamed;
+static QrEncoder encoder;
+
+static void matchesFixture(const char *path) {
+  std::vector<uint8_t> json = readFile(path);
+  EXPECT(QrPayloadDecoder::decode(json.data(), json.size(), fixture), "can't read %s", path);
+  EXPECT(encoder.encode((const uint8_t *)FIXTURE_TEXT, strlen(FIXTURE_TEXT), QR_ECC_M, encoded),
+         "fixture text not encoded");
+  uint32_t diff = differences(fixture, encoded);
+  EXPECT(diff == 0, "%u modules differ from %s (sizes %u, %u)", (unsigned)diff, path,
+         fixture.size(), encoded.size());
+
+  // The same through a text message, fed in chunks
+  std::string msg = std::string("TM") + FIXTURE_TEXT;
+  QrPayloadDecoder d(streamed, &encoder);
+  d.begin();
+  for (size_t i = 0; i < msg.size(); i += 7) {
+    d.feed((const uint8_t *)msg.data() + i, min((size_t)7, msg.size() - i));
+  }
+  EXPECT(d.end(), "text message not decoded");
+  EXPECT(differences(fixture, streamed) == 0, "text message differs from %s", path);
+  printf("fixture:  %ux%u, %u bytes of JSON, %u as a text message\n", fixture.size(), fixture.size(),
+         (unsigned)json.size(), (unsigned)msg.size());
+}
+
+static void rejectsBadMessages() {
+  const char *bad[] = { "T", "TM", "TX123", "T\0" };
+  const unsigned lens[] = { 1, 2, 5, 2 };
+  for (uint8_t i = 0; i < 4; i++) {
+    EXPECT(!QrPayloadDecoder::decode((const uint8_t *)bad[i], lens[i], streamed, &encoder) &&
+           streamed.size() == 0, "bad text message %u accepted", i);
+  }
+  EXPECT(!QrPayloadDecoder::decode((const uint8_t *)"TMabc", 5, streamed), "text accepted without an encoder");
+
+  std::vector<uint8_t> tooLong(2 + QR_ENCODE_MAX_TEXT + 1, 'x');
+  tooLong[0] = 'T';
+  tooLong[1] = 'L';
+  EXPECT(!QrPayloadDecoder::decode(tooLong.data(), tooLong.size(), streamed, &encoder), "859 bytes accepted");
+  EXPECT(QrPayloadDecoder::decode(tooLong.data(), tooLong.size() - 1, streamed, &encoder) &&
+         streamed.size() == 97, "858 bytes not encoded as version 20");
+}
+
+// Byte capacities from the standard's table 7
+static void capacities() {
+  static const struct { uint8_t version; uint16_t bytes[4]; } table[] = {
+    { 1, { 17, 14, 11, 7 } }, { 6, { 134, 106, 74, 58 } },
+    { 10, { 271, 213, 151, 119 } }, { 20, { 858, 666, 482, 382 } }
+  };
+  for (uint8_t i = 0; i < 4; i++) {
+    for (uint8_t ecc = 0; ecc < 4; ecc++) {
+      uint16_t n = table[i].bytes[ecc];
+      EXPECT(QrEncoder::versionFor(n, ecc) == table[i].version, "%u bytes at ecc %u: version %u, not %u",
+             n, ecc, QrEncoder::versionFor(n, ecc), table[i].version);
+      if (table[i].version < QR_ENCODE_MAX_VERSION) {
+        EXPECT(QrEncoder::versionFor(n + 1, ecc) == table[i].version + 1, "%u bytes at ecc %u fit version %u",
+               n + 1, ecc, table[i].version);
+      } else {
+        EXPECT(QrEncoder::versionFor(n + 1, ecc) == 0, "%u bytes at ecc %u fit", n + 1, ecc);
+      }
+    }
+  }
+}
+
+// --- A reader of its own -----------------------------------------------
+
+struct Reader {
+  const QrMatrix &m;
+  uint8_t size, version;
+  std::vector<bool> function;
+
+  explicit Reader(const QrMatrix &matrix) : m(matrix), size(matrix.size()), version((size - 17) / 4) {
+    function.assign(size * size, false);
+    mark(0, 0, 9, 9);
+    mark(size - 8, 0, 8, 9);
+    mark(0, size - 8, 9, 8);
+    mark(6, 0, 1, size);
+    mark(0, 6, size, 1);
+    if (version >= 7) {
+      mark(size - 11, 0, 3, 6);
+      mark(0, size - 11, 6, 3);
+    }
+    // Alignment centres as listed in the standard's annex E
+    static const uint8_t centres[21][4] = {
+      {}, {}, { 18 }, { 22 }, { 26 }, { 30 }, { 34 }, { 22, 38 }, { 24, 42 }, { 26, 46 }, { 28, 50 },
+      { 30, 54 }, { 32, 58 }, { 34, 62 }, { 26, 46, 66 }, { 26, 48, 70 }, { 26, 50, 74 },
+      { 30, 54, 78 }, { 30, 56, 82 }, { 30, 58, 86 }, { 34, 62, 90 }
+    };
+    std::vector<int> pos;
+    if (version >= 2) pos.push_back(6);
+    for (uint8_t i = 0; i < 4 && centres[version][i]; i++) pos.push_back(centres[version][i]);
+    for (size_t i = 0; i < pos.size(); i++) {
+      for (size_t j = 0; j < pos.size(); j++) {
+        bool corner = (i == 0 && j == 0) || (i == 0 && j == pos.size() - 1) || (i == pos.size() - 1 && j == 0);
+        if (!corner) mark(pos[i] - 2, pos[j] - 2, 5, 5);
+      }
+    }
+  }
+
+  void mark(int x, int y, int w, int h) {
+    for (int yy = y; yy < y + h; yy++) {
+      for (int xx = x; xx < x + w; xx++) function[yy * size + xx] = true;
+    }
+  }
+
+  // Format word from the copy around the top-left finder: ECC bits and mask,
+  // -1 if it isn't a valid BCH code word
+  int format() const {
+    uint16_t word = 0;
+    for (uint8_t i = 0; i < 6; i++) word = word << 1 | m.get(i, 8);
+    word = word << 1 | m.get(7, 8);
+    word = word << 1 | m.get(8, 8);
+    word = word << 1 | m.get(8, 7);
+    for (int8_t i = 5; i >= 0; i--) word = word << 1 | m.get(8, i);
+    word ^= 0x5412;
+    uint16_t rem = word;
+    for (int8_t bit = 14; bit >= 10; bit--) {
+      if (rem & (1 << bit)) rem ^= 0x537 << (bit - 10);
+    }
+    return rem ? -1 : word >> 10;
+  }
+
+  // Version from the block right of the bottom-left finder, 0 below 7
+  int versionWord() const {
+    uint32_t word = 0;
+    for (int8_t i = 17; i >= 0; i--) word = word << 1 | m.get(i / 3, size - 11 + i % 3);
+    return word >> 12;
+  }
+
+  std::vector<uint8_t> codewords(uint8_t mask) const {
+    std::vector<uint8_t> out;
+    uint8_t byte = 0, bits = 0;
+    int right = size - 1;
+    while (right >= 1) {
+      if (right == 6) right = 5;
+      for (int vert = 0; vert < size; vert++) {
+        for (int j = 0; j < 2; j++) {
+          int x = right - j;
+          int y = ((right + 1) & 2) ? vert : size - 1 - vert;
+          if (function[y * size + x]) continue;
+          bool inv = false;
+          switch (mask) {
+            case 0: inv = (y + x) % 2 == 0; break;
+            case 1: inv = y % 2 == 0; break;
+            case 2: inv = x % 3 == 0; break;
+            case 3: inv = (y + x) % 3 == 0; break;
+            case 4: inv = (y / 2 + x / 3) % 2 == 0; break;
+            case 5: inv = (y * x) % 2 + (y * x) % 3 == 0; break;
+            case 6: inv = ((y * x) % 2 + (y * x) % 3) % 2 == 0; break;
+            case 7: inv = ((y + x) % 2 + (y * x) % 3) % 2 == 0; break;
+          }
+          byte = byte << 1 | (m.get(x, y) ^ inv);
+          if (++bits == 8) {
+            out.push_back(byte);
+            bits = 0;
+          }
+        }
+      }
+      right -= 2;
+    }
+    return out;
+  }
+};
+
+// GF(256) by log tables, unlike the encoder's shift-and-add
+static uint8_t gfExp[512], gfLog[256];
+
+static void gfInit() {
+  uint16_t x = 1;
+  for (uint16_t i = 0; i < 255; i++) {
+    gfExp[i] = gfExp[i + 255] = x;
+    gfLog[x] = i;
+    x <<= 1;
+    if (x & 0x100) x ^= 0x11D;
+  }
+}
+
+// Every syndrome is zero for a valid block
+static bool syndromesZero(const std::vector<uint8_t> &block, uint8_t eccLen) {
+  for (uint8_t i = 0; i < eccLen; i++) {
+    uint8_t s = 0;
+    for (size_t k = 0; k < block.size(); k++) {
+      s = (s ? gfExp[gfLog[s] + i] : 0) ^ block[k];
+    }
+    if (s) return false;
+  }
+  return true;
+}
+
+static uint32_t readBits(const std::vector<uint8_t> &data, uint32_t &bit, uint8_t n) {
+  uint32_t v = 0;
+  for (uint8_t i = 0; i < n; i++, bit++) v = v << 1 | ((data[bit / 8] >> (7 - bit % 8)) & 1);
+  return v;
+}
+
+static void roundTrips() {
+  static const char LEVEL[4] = { 1, 0, 3, 2 };
+  uint32_t seed = 12345, codes = 0;
+  for (uint8_t ecc = 0; ecc < 4; ecc++) {
+    for (uint8_t version = 1; version <= QR_ENCODE_MAX_VERSION; version++) {
+      // The most the version holds, and one byte more than the version below
+      uint16_t most = (QrEncoder::dataCodewords(version, ecc) * 8 - 4 - (version < 10 ? 8 : 16)) / 8;
+      for (uint8_t pick = 0; pick < 2; pick++) {
+        uint16_t len = pick ? most : (version > 1 ? (QrEncoder::dataCodewords(version - 1, ecc) * 8 - 4 -
+                                                      (version - 1 < 10 ? 8 : 16)) / 8 + 1 : 1);
+        std::vector<uint8_t> text(len);
+        for (uint16_t i = 0; i < len; i++) text[i] = (seed = seed * 1103515245 + 12345) >> 16;
+
+        QrMatrix &m = encoded;
+        bool ok = encoder.encode(text.data(), len, ecc, m);
+        EXPECT(ok && m.size() == 17 + 4 * version, "%u bytes at ecc %u: size %u, not version %u",
+               len, ecc, m.size(), version);
+        if (!ok) continue;
+        codes++;
+
+        Reader r(m);
+        int format = r.format();
+        EXPECT(format >= 0 && (format >> 3) == LEVEL[ecc], "v%u ecc %u: format word %d", version, ecc, format);
+        if (format < 0) continue;
+        if (version >= 7) EXPECT(r.versionWord() == version, "v%u: version word %d", version, r.versionWord());
+
+        std::vector<uint8_t> cw = r.codewords(format & 7);
+        uint16_t total = QrEncoder::totalCodewords(version);
+        EXPECT(cw.size() == total, "v%u: %u codewords, not %u", version, (unsigned)cw.size(), total);
+        if (cw.size() < total) continue;
+
+        // De-interleave
+        uint8_t blocks = pgm_read_byte(&QR_ECC_BLOCKS[ecc][version]);
+        uint8_t eccLen = pgm_read_byte(&QR_ECC_PER_BLOCK[ecc][version]);
+        uint16_t dataLen = total - blocks * eccLen;
+        uint8_t shortBlocks = blocks - total % blocks;
+        uint16_t shortData = total / blocks - eccLen;
+        std::vector<std::vector<uint8_t> > block(blocks);
+        uint16_t k = 0;
+        for (uint16_t i = 0; i <= shortData; i++) {
+          for (uint8_t b = 0; b < blocks; b++) {
+            if (i < shortData || b >= shortBlocks) block[b].push_back(cw[k++]);
+          }
+        }
+        std::vector<uint8_t> data;
+        for (uint8_t b = 0; b < blocks; b++) data.insert(data.end(), block[b].begin(), block[b].end());
+        EXPECT(k == dataLen, "v%u: %u data codewords, not %u", version, k, dataLen);
+        for (uint16_t i = 0; i < eccLen; i++) {
+          for (uint8_t b = 0; b < blocks; b++) block[b].push_back(cw[k++]);
+        }
+        bool syndromes = true;
+        for (uint8_t b = 0; b < blocks; b++) syndromes &= syndromesZero(block[b], eccLen);
+        EXPECT(syndromes, "v%u ecc %u: a block fails its syndromes", version, ecc);
+
+        // Byte mode, count, text
+        uint32_t bit = 0;
+        uint32_t mode = readBits(data, bit, 4);
+        uint32_t count = readBits(data, bit, version < 10 ? 8 : 16);
+        bool same = mode == 4 && count == len;
+        for (uint16_t i = 0; same && i < len; i++) same = readBits(data, bit, 8) == text[i];
+        EXPECT(same, "v%u ecc %u: text doesn't read back", version, ecc);
+      }
+    }
+  }
+  printf("encode:   %u codes, versions 1-%u at L/M/Q/H read back\n", (unsigned)codes, QR_ENCODE_MAX_VERSION);
+}
+
+// --- QrCache.h ----------------------------------------------------------
+
+// The part of fs::FS / fs::File the cache uses, over a map of byte vectors
+struct HostFile {
+  std::vector<uint8_t> *data;
+  size_t pos;
+  operator bool() const { return data != NULL; }
+  size_t read(uint8_t *buf, size_t len) {
+    len = min(len, data->size() - pos);
+    memcpy(buf, data->data() + pos, len);
+    pos += len;
+    return len;
+  }
+  size_t write(const uint8_t *buf, size_t len) {
+    data->insert(data->end(), buf, buf + len);
+    return len;
+  }
+  void close() {}
+};
+
+struct HostFS {
+  std::map<std::string, std::vector<uint8_t> > files;
+  uint32_t writes;
+  HostFS() : writes(0) {}
+
+  bool exists(const char *path) { return files.count(path) != 0; }
+  bool remove(const char *path) { return files.erase(path) != 0; }
+  HostFile open(const char *path, const char *mode) {
+    HostFile f = { NULL, 0 };
+    if (mode[0] == 'w') {
+      writes++;
+      files[path].clear();
+    } else if (!exists(path)) {
+      return f;
+    }
+    f.data = &files[path];
+    return f;
+  }
+};
+
+static QrMatrix codes[QR_CACHE_FLASH + 1];
+static uint32_t keys[QR_CACHE_FLASH + 1];
+
+static void cache() {
+  for (uint8_t i = 0; i <= QR_CACHE_FLASH; i++) {
+    char msg[32];
+    snprintf(msg, sizeof(msg), "TMPAYMENT-%u", i);
+    keys[i] = QrCache<HostFS>::hash((const uint8_t *)msg, strlen(msg));
+    QrPayloadDecoder::decode((const uint8_t *)msg, strlen(msg), codes[i], &encoder);
+  }
+
+  HostFS fs;
+  QrCache<HostFS> *c = new QrCache<HostFS>();
+  c->begin(&fs);
+  QrMatrix &out = streamed;
+  EXPECT(!c->find(keys[0], out), "empty cache found a code");
+  for (uint8_t i = 0; i <= QR_CACHE_RAM; i++) c->put(keys[i], codes[i]);
+
+  // Code 0 left RAM for the fifth, but flash still has it; hits never write
+  uint32_t writes = fs.writes;
+  for (uint8_t i = 0; i <= QR_CACHE_RAM; i++) {
+    EXPECT(c->find(keys[i], out) && differences(out, codes[i]) == 0, "code %u not found", i);
+  }
+  EXPECT(fs.writes == writes, "%u flash writes on hits", (unsigned)(fs.writes - writes));
+
+  // Fill flash past its size: the least recently shown one goes (code 0 was
+  // found first above, so it is the oldest; touch it again to keep it)
+  EXPECT(c->find(keys[0], out), "code 0 lost");
+  for (uint8_t i = QR_CACHE_RAM + 1; i <= QR_CACHE_FLASH; i++) c->put(keys[i], codes[i]);
+  EXPECT(c->inFlash() == QR_CACHE_FLASH, "%u codes in flash", c->inFlash());
+  EXPECT(fs.files.size() == QR_CACHE_FLASH + 1u, "%u files", (unsigned)fs.files.size());
+  delete c;
+
+  // After a reboot everything but code 1 comes back from flash
+  c = new QrCache<HostFS>();
+  c->begin(&fs);
+  EXPECT(!c->find(keys[1], out), "evicted code 1 found after reboot");
+  uint8_t found = 0;
+  for (uint8_t i = 0; i <= QR_CACHE_FLASH; i++) {
+    if (i != 1) found += c->find(keys[i], out) && differences(out, codes[i]) == 0;
+  }
+  EXPECT(found == QR_CACHE_FLASH, "%u of %u codes after reboot", found, QR_CACHE_FLASH);
+
+  // A file that went missing is dropped, not shown
+  char path[24];
+  snprintf(path, sizeof(path), QR_CACHE_PREFIX "%08lx", (unsigned long)keys[2]);
+  fs.remove(path);
+  delete c;
+  c = new QrCache<HostFS>();
+  c->begin(&fs);
+  EXPECT(!c->find(keys[2], out) && out.size() == 0, "missing file found");
+  EXPECT(c->inFlash() == QR_CACHE_FLASH - 1, "missing file still indexed");
+  delete c;
+
+  // 'H' messages name a hash
+  char msg[16];
+  snprintf(msg, sizeof(msg), "H%08lX", (unsigned long)keys[3]);
+  uint32_t key = 0;
+  EXPECT(QrCache<HostFS>::hashMessage((const uint8_t *)msg, 9, key) && key == keys[3], "hash message misread");
+  EXPECT(!QrCache<HostFS>::hashMessage((const uint8_t *)"H1234567g", 9, key), "bad hash message accepted");
+  EXPECT(!QrCache<HostFS>::hashMessage((const uint8_t *)"TM12345678", 10, key), "text taken for a hash");
+  printf("cache:    %u in RAM, %u in flash, %u flash writes\n", QR_CACHE_RAM, QR_CACHE_FLASH,
+         (unsigned)fs.writes);
+}
+
+int main() {
+  gfInit();
+  matchesFixture("../matrix-qr.txt");
+  rejectsBadMessages();
+  capacities();
+  roundTrips();
+  cache();
+  return checkReport("qr");
+}
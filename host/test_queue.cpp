@@ -0,0 +1,149 @@
+/***************************************************
+ * test_queue.cpp - Threaded checks for RoboEyesQueue.h
+ * and RoboEyesTask.h on real host threads: nothing
+ * posted is lost or reordered, and a handed-off state
+ * is never seen half written.
+ ***************************************************/
+
+#include <Arduino.h>
+#include "RoboEyesQueue.h"
+#include "RoboEyesTask.h"
+#include "Check.h"
+#include <thread>
+
+static void spscOrder() {
+  static const uint32_t COUNT = 500000;
+  EyeSpscQueue<uint32_t, 64> queue;
+  uint32_t fullRetries = 0;
+
+  std::thread producer([&] {
+    for (uint32_t i = 1; i <= COUNT; i++) {
+      while (!queue.push(i)) { fullRetries++; std::this_thread::yield(); }
+    }
+  });
+
+  uint32_t expected = 1, bad = 0, got;
+  while (expected <= COUNT) {
+    if (!queue.pop(got)) { std::this_thread::yield(); continue; }
+    if (got != expected) bad++;
+    expected = got + 1;
+  }
+  producer.join();
+
+  EXPECT(bad == 0, "%u items out of order", (unsigned)bad);
+  EXPECT(queue.empty(), "queue not empty at the end");
+  printf("spsc:     %u items, %u full retries\n", (unsigned)COUNT, (unsigned)fullRetries);
+}
+
+// Every word carries the sequence number, so a torn copy shows up
+struct Snapshot {
+  uint32_t seq;
+  uint32_t words[255];
+};
+
+static void handoffConsistent() {
+  static const uint32_t COUNT = 200000;
+  EyeHandoff<Snapshot> handoff;
+  std::atomic<bool> done(false);
+
+  std::thread writer([&] {
+    for (uint32_t i = 1; i <= COUNT; i++) {
+      Snapshot &s = handoff.back();
+      s.seq = i;
+      for (uint16_t w = 0; w < 255; w++) s.words[w] = i;
+      handoff.publish();
+    }
+    done.store(true);
+  });
+
+  uint32_t last = 0, seen = 0, torn = 0, backwards = 0;
+  for (;;) {
+    bool finished = done.load();
+    if (handoff.acquire()) {
+      const Snapshot &s = handoff.front();
+      for (uint16_t w = 0; w < 255; w++) {
+        if (s.words[w] != s.seq) { torn++; break; }
+      }
+      if (s.seq <= last) backwards++;
+      last = s.seq;
+      seen++;
+    }
+    if (finished && !handoff.acquire()) break;
+  }
+  writer.join();
+
+  EXPECT(torn == 0, "%u torn snapshots", (unsigned)torn);
+  EXPECT(backwards == 0, "%u stale snapshots", (unsigned)backwards);
+  EXPECT(last == COUNT, "reader ended on %u, not the last snapshot %u", (unsigned)last, (unsigned)COUNT);
+  printf("handoff:  %u published, %u seen by the reader\n", (unsigned)COUNT, (unsigned)seen);
+}
+
+// Records what the render task applies, in order
+struct FakeEyes {
+  uint32_t moods, userCommands;
+  std::atomic<uint32_t> frames;
+  uint16_t lastMood;
+  bool ordered;
+
+  FakeEyes() : moods(0), frames(0), userCommands(0), lastMood(0), ordered(true) {}
+
+  void update() { frames++; }
+  void setMood(uint8_t mood) {
+    // Moods are posted as 0..255 repeating
+    if (moods && mood != (uint8_t)(lastMood + 1)) ordered = false;
+    lastMood = mood;
+    moods++;
+  }
+  void setPosition(uint8_t) {}
+  void blink(bool, bool) {}
+  void open(bool, bool) {}
+  void close(bool, bool) {}
+  void anim_confused() {}
+  void anim_laugh() {}
+  void setCuriosity(bool) {}
+  void setCyclops(bool) {}
+  void setSweat(bool) {}
+  void setAutoblinker(bool, int, int) {}
+  void setIdleMode(bool, int, int) {}
+  template<typename Out> void dumpStats(Out &) {}
+  void resetStats() {}
+};
+
+static void onUser(FakeEyes &eyes, const EyeCommand &cmd) {
+  if (cmd.type == EYE_CMD_USER && cmd.value == 0xBEEF) eyes.userCommands++;
+}
+
+static void renderTask() {
+  static const uint32_t COUNT = 20000;
+  FakeEyes eyes;
+  RoboEyesTask<FakeEyes> task(eyes);
+  task.setCommandHook(onUser);
+  EXPECT(task.begin(), "render task did not start");
+
+  for (uint32_t i = 0; i < COUNT; i++) {
+    while (!task.post(EYE_CMD_MOOD, (uint8_t)i)) std::this_thread::yield();
+  }
+  while (!task.post(EYE_CMD_USER, 0, 0, 0xBEEF)) std::this_thread::yield();
+  while (!task.post(EYE_CMD_PAUSE)) std::this_thread::yield();
+
+  // The pause is the last command; once frames stop, everything was applied
+  uint32_t frames;
+  do {
+    frames = eyes.frames.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  } while (frames != eyes.frames.load());
+  task.end();
+
+  EXPECT(!task.running(), "render task still running after end()");
+  EXPECT(eyes.moods == COUNT, "%u of %u moods applied", (unsigned)eyes.moods, (unsigned)COUNT);
+  EXPECT(eyes.ordered, "moods applied out of order");
+  EXPECT(eyes.userCommands == 1, "user command reached the hook %u times", (unsigned)eyes.userCommands);
+  printf("task:     %u commands, %u frames\n", (unsigned)eyes.moods, (unsigned)eyes.frames.load());
+}
+
+int main() {
+  spscOrder();
+  handoffConsistent();
+  renderTask();
+  return checkReport("queue");
+}